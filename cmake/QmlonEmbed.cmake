@@ -0,0 +1,33 @@
+# Provides qmlon_embed(target input name), which embeds a QMLON document in a
+# target. The generated header <name>.h declares a function <name>()
+# returning the root of the document, which is compiled into the target and
+# read in place without parsing.
+#
+# The qmlon-embed tool is the qmlon-embed target if there is one, built or
+# imported. Otherwise it is looked up next to this module when installed,
+# then in the path. Set QMLON_EMBED_EXECUTABLE to use another one.
+
+set(QMLON_EMBED_MODULE_DIR ${CMAKE_CURRENT_LIST_DIR})
+
+function(qmlon_embed target input name)
+  if(TARGET qmlon-embed)
+    set(tool qmlon-embed)
+  else()
+    find_program(QMLON_EMBED_EXECUTABLE qmlon-embed
+      HINTS ${QMLON_EMBED_MODULE_DIR}/../../../bin)
+    if(NOT QMLON_EMBED_EXECUTABLE)
+      message(FATAL_ERROR "qmlon_embed: the qmlon-embed tool was not found, set QMLON_EMBED_EXECUTABLE")
+    endif()
+    set(tool ${QMLON_EMBED_EXECUTABLE})
+  endif()
+
+  get_filename_component(input ${input} ABSOLUTE)
+  set(output ${CMAKE_CURRENT_BINARY_DIR}/embedded/${name})
+  file(MAKE_DIRECTORY ${CMAKE_CURRENT_BINARY_DIR}/embedded)
+  add_custom_command(OUTPUT ${output}.h ${output}.cpp
+    COMMAND ${tool} ${input} ${output}.h ${output}.cpp ${name}
+    DEPENDS ${tool} ${input}
+    COMMENT "Embedding ${input}")
+  target_sources(${target} PRIVATE ${output}.h ${output}.cpp)
+  target_include_directories(${target} PRIVATE ${CMAKE_CURRENT_BINARY_DIR}/embedded)
+endfunction()
@@ -2,121 +2,346 @@
 #define QMLON_HH
 
 #include <cstdlib>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <map>
 #include <vector>
 #include <stdexcept>
 #include <memory>
+#include "qmlonstringref.h"
+#include "qmlonatom.h"
+#include "qmlonsource.h"
+#include "qmlonarena.h"
 
 namespace qmlon
 {
   class Object;
 
+  // A value of a document: a boolean, integer, float, string, object or list.
+  // Values are 16 bytes. Scalars and strings of up to 14 bytes are stored
+  // inline, longer strings refer to data owned by the document, usually its
+  // source text, and objects and lists live in the arena of the document.
+  //
+  // Values and objects of a parsed document live in the arena of its
+  // Document. References to them do not own anything, except the root
+  // reference returned by readValue and Document::getRoot, which keeps the
+  // whole document alive. Other references are valid as long as the root is,
+  // except string references to strings stored inline, see asStringRef.
   class Value
   {
   public:
-    typedef std::shared_ptr<Value> Reference;
-    typedef std::vector<Reference> List;
-
-    virtual bool isBoolean() const { return false; }
-    virtual bool isInteger() const { return false; }
-    virtual bool isFloat() const { return false; }
-    virtual bool isString() const { return false; }
-    virtual bool isObject() const { return false; }
-    virtual bool isList() const { return false; }
-
-    virtual bool asBoolean() const { throw std::runtime_error("Invalid use of QMLON value. Value type is not boolean!"); }
-    virtual int asInteger() const { throw std::runtime_error("Invalid use of QMLON value. Value type is not integer!"); }
-    virtual float asFloat() const { throw std::runtime_error("Invalid use of QMLON value. Value type is not float!"); }
-    virtual std::string const& asString() const { throw std::runtime_error("Invalid use of QMLON value. Value type is not string!"); }
-    virtual Object& asObject() const { throw std::runtime_error("Invalid use of QMLON value. Value type is not object!"); }
-    virtual List const& asList() const { throw std::runtime_error("Invalid use of QMLON value. Value type is not list!"); }
+    typedef std::shared_ptr<Value const> Reference;
+    typedef std::vector<Value, ArenaAllocator<Value>> List;
+
+    enum Type : std::uint8_t { BOOLEAN, INTEGER, FLOAT, STRING, OBJECT, LIST };
+
+    // Strings up to this length are stored inline
+    static std::size_t const INLINE_STRING_CAPACITY = 14;
+
+    static Value createBoolean(bool value) { return Value(BOOLEAN, value); }
+    static Value createInteger(std::int64_t value) { return Value(INTEGER, value); }
+    static Value createFloat(double value) { return Value(FLOAT, value); }
+    static Value createString(StringRef value);
+    static Value createObject(Object* value) { return Value(OBJECT, value); }
+    static Value createList(List const* value) { return Value(LIST, value); }
+
+    Type getType() const { return type; }
+
+    bool isBoolean() const { return type == BOOLEAN; }
+    bool isInteger() const { return type == INTEGER; }
+    bool isFloat() const { return type == FLOAT || type == INTEGER; }
+    bool isString() const { return type == STRING; }
+    bool isObject() const { return type == OBJECT; }
+    bool isList() const { return type == LIST; }
+
+    // Integers are stored in 64 bits and floats as doubles. asInteger and
+    // asFloat narrow them, asInteger throws if the integer does not fit.
+    bool asBoolean() const { return isBoolean() ? load<bool>() : typeError<bool>("boolean"); }
+    int asInteger() const;
+    float asFloat() const { return static_cast<float>(asDouble()); }
+    std::int64_t asInt64() const { return isInteger() ? load<std::int64_t>() : typeError<std::int64_t>("integer"); }
+    double asDouble() const { return type == FLOAT ? load<double>() : isInteger() ? load<std::int64_t>() : typeError<double>("float"); }
+    // asString returns a copy; it used to return a reference, which strings
+    // stored inline cannot provide. asStringRef does not copy, but strings
+    // of up to 14 bytes are stored in the value itself, so a reference to
+    // one is only valid as long as that value is, not as long as the root.
+    std::string asString() const { return asStringRef().str(); }
+    StringRef asStringRef() const { return isString() ? stringRef() : typeError<StringRef>("string"); }
+    Object& asObject() const { return isObject() ? *load<Object*>() : *typeError<Object*>("object"); }
+    List const& asList() const { return isList() ? *load<List const*>() : *typeError<List const*>("list"); }
+
+    // Non-throwing accessors. The scalar ones store the value in result and
+    // return false without touching it if the value has a different type or
+    // does not fit.
+    bool tryAsBoolean(bool& result) const { if(!isBoolean()) return false; result = load<bool>(); return true; }
+    bool tryAsInteger(int& result) const;
+    bool tryAsFloat(float& result) const { double d; if(!tryAsDouble(d)) return false; result = static_cast<float>(d); return true; }
+    bool tryAsInt64(std::int64_t& result) const { if(!isInteger()) return false; result = load<std::int64_t>(); return true; }
+    bool tryAsDouble(double& result) const { if(!isFloat()) return false; result = type == FLOAT ? load<double>() : load<std::int64_t>(); return true; }
+    bool tryAsStringRef(StringRef& result) const { if(!isString()) return false; result = stringRef(); return true; }
+    Object* tryAsObject() const { return isObject() ? load<Object*>() : nullptr; }
+    List const* tryAsList() const { return isList() ? load<List const*>() : nullptr; }
 
     std::string str() const;
-  };
 
-  class Object
-  {
-  public:
-    typedef std::shared_ptr<Object> Reference;
-    typedef std::map<std::string, Value::Reference> Properties;
-    typedef std::vector<Object::Reference> Children;
+  private:
+    static std::uint8_t const EXTERNAL_STRING = 0xff;
 
-    Object() : type(), properties(), children() {}
+    explicit Value(Type type) : storage(), inlineLength(0), type(type) {}
 
-    bool hasProperty(std::string const& name) const { properties.find(name) != properties.end(); }
-    Value::Reference getProperty(std::string const& name){ return properties.find(name)->second; }
+    template<typename T>
+    Value(Type type, T value) : storage(), inlineLength(0), type(type) { std::memcpy(storage, &value, sizeof(T)); }
 
-    std::string type;
-    Properties properties;
-    Children children;
+    template<typename T>
+    T load() const { T value; std::memcpy(&value, storage, sizeof(T)); return value; }
+
+    template<typename T>
+    static T typeError(char const* expected);
+
+    // Inline strings point to the value itself, so they are only valid as
+    // long as the value is
+    StringRef stringRef() const
+    {
+      if(inlineLength == EXTERNAL_STRING)
+      {
+        std::uint32_t length;
+        std::memcpy(&length, storage + sizeof(char const*), sizeof(length));
+        return StringRef(load<char const*>(), length);
+      }
+      return StringRef(storage, inlineLength);
+    }
+
+    alignas(8) char storage[INLINE_STRING_CAPACITY];
+    std::uint8_t inlineLength;
+    Type type;
   };
 
-  class BooleanValue : public Value
+  static_assert(sizeof(Value) == 16, "qmlon::Value must stay 16 bytes");
+
+  template<typename T>
+  T Value::typeError(char const* expected)
   {
-  public:
-    BooleanValue(bool value) : value(value) {}
-    bool isBoolean() const { return true; }
-    bool asBoolean() const { return value; }
-  private:
-    bool value;
-  };
+    throw std::runtime_error(std::string("Invalid use of QMLON value. Value type is not ") + expected + "!");
+  }
 
-  class IntegerValue : public Value
+  // Content of an object that is read from the source on first access, see
+  // readValueOnDemand
+  class DeferredObject;
+  class ObjectLoader;
+  void load(DeferredObject* deferred);
+
+  // Properties of an object as a flat list of name-value pairs in source
+  // order. Small objects are searched linearly. Once an object has more than
+  // INDEX_THRESHOLD properties, lookups go through an open addressing hash
+  // index of positions in the list.
+  class Properties
   {
   public:
-    IntegerValue(int value) : value(value) {}
-    bool isInteger() const { return true; }
-    bool isFloat() const { return true; }
-    int asInteger() const { return value; }
-    float asFloat() const { return value; }
+    typedef std::pair<Atom, Value> value_type;
+    typedef std::vector<value_type, ArenaAllocator<value_type>> Entries;
+    typedef Entries::iterator iterator;
+    typedef Entries::const_iterator const_iterator;
+
+    static std::size_t const INDEX_THRESHOLD = 8;
+
+    Properties(Arena* arena = nullptr) : entries(arena), index(arena), deferred(nullptr) {}
+
+    iterator begin() { load(); return entries.begin(); }
+    iterator end() { load(); return entries.end(); }
+    const_iterator begin() const { load(); return entries.begin(); }
+    const_iterator end() const { load(); return entries.end(); }
+    std::size_t size() const { load(); return entries.size(); }
+    bool empty() const { load(); return entries.empty(); }
+
+    iterator find(Atom name) { load(); return entries.begin() + position(name); }
+    const_iterator find(Atom name) const { load(); return entries.begin() + position(name); }
+
+    // Appends a property unless one with the same name exists. Returns the
+    // property of that name and whether it was inserted.
+    std::pair<iterator, bool> insert(value_type const& value);
+
   private:
-    int value;
+    friend class DeferredObject;
+
+    void load() const { if(deferred) qmlon::load(deferred); }
+
+    // Position of the property in entries, or the size of entries if missing
+    std::size_t position(Atom name) const;
+    void addToIndex(std::size_t i);
+    void rebuildIndex();
+
+    static std::size_t slot(Atom name, std::size_t mask) { return (name.id() * 2654435761u) & mask; }
+
+    Entries entries;
+    // Positions in entries plus one, zero marks an empty slot
+    std::vector<std::uint32_t, ArenaAllocator<std::uint32_t>> index;
+    DeferredObject* deferred;
   };
 
-  class FloatValue : public Value
+  // Child objects of an object in source order. Children belong to the
+  // document, see Object.
+  class Children
   {
   public:
-    FloatValue(float value) : value(value) {}
-    bool isFloat() const { return true; }
-    float asFloat() const { return value; }
+    typedef Object* value_type;
+    typedef std::vector<value_type, ArenaAllocator<value_type>> Entries;
+    typedef Entries::iterator iterator;
+    typedef Entries::const_iterator const_iterator;
+
+    Children(Arena* arena = nullptr) : entries(arena), deferred(nullptr) {}
+
+    iterator begin() { load(); return entries.begin(); }
+    iterator end() { load(); return entries.end(); }
+    const_iterator begin() const { load(); return entries.begin(); }
+    const_iterator end() const { load(); return entries.end(); }
+    std::size_t size() const { load(); return entries.size(); }
+    bool empty() const { load(); return entries.empty(); }
+    value_type const& operator[](std::size_t i) const { load(); return entries[i]; }
+    value_type const& front() const { load(); return entries.front(); }
+    value_type const& back() const { load(); return entries.back(); }
+
+    void push_back(value_type const& child) { load(); entries.push_back(child); }
+    iterator erase(const_iterator position) { load(); return entries.erase(position); }
+
   private:
-    float value;
+    friend class DeferredObject;
+
+    void load() const { if(deferred) qmlon::load(deferred); }
+
+    Entries entries;
+    DeferredObject* deferred;
   };
 
-  class StringValue : public Value
+  // Objects, their property values and their children belong to a
+  // document. They are handed out as plain pointers and references, which
+  // are only valid as long as the document is, for example while the root
+  // reference is held.
+  class Object
   {
   public:
-    StringValue(std::string const& value) : value(value) {}
-    bool isString() const { return true; }
-    std::string const& asString() const { return value; }
-  private:
-    std::string value;
+    typedef std::shared_ptr<Object> Reference;
+    typedef qmlon::Properties Properties;
+    typedef qmlon::Children Children;
+
+    Object(Arena* arena = nullptr) : type(), properties(arena), children(arena) {}
+
+    bool hasProperty(Atom name) const { return properties.find(name) != properties.end(); }
+    bool hasProperty(StringRef name) const;
+    // Value of a property, or null if there is none
+    Value const* getProperty(Atom name) const;
+    Value const* getProperty(StringRef name) const;
+
+    // Sets a property, replacing an earlier value of the same name
+    void setProperty(Atom name, Value const& value);
+
+    // The type is always available. The properties and children of objects
+    // read on demand are loaded when either is first accessed.
+    Atom type;
+    Properties properties;
+    Children children;
   };
 
-  class ObjectValue : public Value
+  // Owns the memory of a document: its source text and an arena holding all
+  // values, objects, strings and containers. Nodes are never destroyed one by
+  // one, freeing a document just releases the arena.
+  class Document : public std::enable_shared_from_this<Document>
   {
   public:
-    ObjectValue(Object::Reference value) : value(value) {}
-    bool isObject() const { return true; }
-    Object& asObject() const { return *value; }
+    typedef std::shared_ptr<Document> Reference;
+
+    static Reference create(Source::Reference const& source = Source::Reference());
+
+    Arena& getArena() { return arena; }
+    Source::Reference const& getSource() const { return source; }
+
+    // Reference to the root value that keeps the document alive
+    Value::Reference getRoot();
+    void setRoot(Value const& value) { root = arena.create<Value>(value); }
+
+    // Values referring to memory owned by the document. The string is copied
+    // into the arena unless it is short enough to be stored inline.
+    Value createString(StringRef value);
+    Value createObject(Object* object) { return Value::createObject(object); }
+    Value createList(Value::List list) { return Value::createList(arena.create<Value::List>(std::move(list))); }
+    Value::List createList() { return Value::List(&arena); }
+    Object* createObject(Atom type);
+
+    // Loader of the deferred objects of the document, kept alive with it
+    void setLoader(std::shared_ptr<ObjectLoader> const& value) { loader = value; }
+
+    // Keeps another document alive with this one, for values referring to
+    // memory owned by it
+    void addPart(Reference const& part) { parts.push_back(part); }
+
   private:
-    Object::Reference value;
+    Document(Source::Reference const& source);
+
+    Source::Reference source;
+    Arena arena;
+    Value const* root;
+    std::shared_ptr<ObjectLoader> loader;
+    std::vector<Reference> parts;
   };
 
-  class ListValue : public Value
+  // Receives the structure of a document as a stream of events, in source
+  // order. A property is reported with onProperty followed by the events of
+  // its value. Child objects are reported with onObjectStart without a
+  // preceding onProperty. Strings in scalar values passed to onValue may
+  // refer to the source, which is only guaranteed to live during parsing.
+  // Strings with escapes are decoded into a buffer of the parser, which is
+  // only valid during the call.
+  class Handler
   {
   public:
-    ListValue(List value) : value(value) {}
-    bool isList() const { return true; }
-    List const& asList() const { return value; }
-  private:
-    List value;
+    virtual ~Handler() {}
+
+    virtual void onObjectStart(Atom /*type*/) {}
+    virtual void onObjectEnd() {}
+    virtual void onProperty(Atom /*name*/) {}
+    virtual void onListStart() {}
+    virtual void onListEnd() {}
+    virtual void onValue(Value const& /*value*/) {}
   };
 
+  // Streams a document through a handler without building it. Memory use is
+  // bounded by the nesting depth of the document.
+  void parse(Source::Reference const& source, Handler& handler);
+  void parse(std::istream& stream, Handler& handler);
+  void parse(std::string const& str, Handler& handler);
+
+  Document::Reference readDocument(Source::Reference const& source);
+
+  // Reads a document on demand. A first pass only indexes the brackets of the
+  // source. The properties and children of an object are read when they are
+  // first accessed, and subtrees that are never reached are never read.
+  // Syntax errors inside an object are reported when it is loaded. Loading
+  // modifies the document, so a document read on demand must not be accessed
+  // from several threads at once.
+  Document::Reference readDocumentOnDemand(Source::Reference const& source);
+  Value::Reference readValueOnDemand(Source::Reference const& source);
+  Value::Reference readFileOnDemand(std::string const& filename);
+
+  // Reads a document using several threads, by default one per core. The
+  // content of the root object is split at the ends of its members and the
+  // parts are read in parallel, then joined in source order. Documents
+  // whose root is not an object, and small ones, are read in one piece.
+  Document::Reference readDocumentParallel(Source::Reference const& source, unsigned int threads = 0);
+  Value::Reference readValueParallel(Source::Reference const& source, unsigned int threads = 0);
+  Value::Reference readFileParallel(std::string const& filename, unsigned int threads = 0);
+
+  // Reads a document sharing one instance of each distinct object, list and
+  // long string, see qmlonhash.h for how values are compared. Repetitive
+  // documents take less memory, at the cost of hashing every subtree. As
+  // equal subtrees are the same objects, the document must not be modified.
+  Document::Reference readDocumentDeduplicated(Source::Reference const& source);
+  Value::Reference readValueDeduplicated(Source::Reference const& source);
+
+  Value::Reference readValue(Source::Reference const& source);
   Value::Reference readValue(std::istream& stream);
   Value::Reference readValue(std::string const& str);
+  // Reads a text or binary document, see qmlonbinary.h
   Value::Reference readFile(std::string const& filename);
 }
 
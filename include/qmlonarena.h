@@ -0,0 +1,122 @@
+#ifndef QMLON_ARENA_HH
+#define QMLON_ARENA_HH
+
+#include "qmlonstringref.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace qmlon
+{
+  // Bump allocator. Memory is handed out from large chunks and is only
+  // released when the arena is destroyed, all at once, or back to a mark
+  // taken earlier. Objects created in an
+  // arena are never destroyed, so they must not own memory outside of it.
+  class Arena
+  {
+  private:
+    struct Chunk;
+
+  public:
+    // Position in the arena, see release
+    struct Mark
+    {
+      Chunk* chunks;
+      char* cursor;
+      char* limit;
+    };
+
+    Arena();
+    Arena(Arena const&) = delete;
+    Arena& operator=(Arena const&) = delete;
+    ~Arena();
+
+    void* allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t))
+    {
+      std::uintptr_t p = (reinterpret_cast<std::uintptr_t>(cursor) + alignment - 1) & ~(alignment - 1);
+      if(p + size > reinterpret_cast<std::uintptr_t>(limit))
+      {
+        return allocateChunk(size, alignment);
+      }
+
+      cursor = reinterpret_cast<char*>(p + size);
+      return reinterpret_cast<void*>(p);
+    }
+
+    template<typename T, typename... Args>
+    T* create(Args&&... args)
+    {
+      return new(allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // Copies a string into the arena
+    StringRef copy(StringRef str);
+
+    // Total size of the chunks allocated so far
+    std::size_t capacity() const { return reserved; }
+
+    Mark mark() const { return Mark{chunks, cursor, limit}; }
+
+    // Releases everything allocated since the mark was taken. Nothing
+    // allocated after it may be used any more.
+    void release(Mark const& mark);
+
+  private:
+    struct Chunk
+    {
+      Chunk* previous;
+      std::size_t size;
+    };
+
+    void* allocateChunk(std::size_t size, std::size_t alignment);
+
+    Chunk* chunks;
+    char* cursor;
+    char* limit;
+    std::size_t reserved;
+  };
+
+  // Standard allocator allocating from an arena. Deallocation is a no-op.
+  // Without an arena the global heap is used, so containers using this
+  // allocator also work outside of arenas.
+  template<typename T>
+  class ArenaAllocator
+  {
+  public:
+    typedef T value_type;
+
+    ArenaAllocator(Arena* arena = nullptr) : arena(arena) {}
+    template<typename U> ArenaAllocator(ArenaAllocator<U> const& other) : arena(other.arena) {}
+
+    T* allocate(std::size_t n)
+    {
+      return static_cast<T*>(arena ? arena->allocate(n * sizeof(T), alignof(T)) : ::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, std::size_t)
+    {
+      if(!arena)
+      {
+        ::operator delete(p);
+      }
+    }
+
+    template<typename U> bool operator==(ArenaAllocator<U> const& other) const { return arena == other.arena; }
+    template<typename U> bool operator!=(ArenaAllocator<U> const& other) const { return arena != other.arena; }
+
+    Arena* arena;
+  };
+
+  // Shared pointer that does not own its target. Used to refer to objects
+  // whose lifetime is managed elsewhere, such as by an arena. Copying it does
+  // not touch any reference count.
+  template<typename T>
+  std::shared_ptr<T> unowned(T* ptr)
+  {
+    return std::shared_ptr<T>(std::shared_ptr<T>(), ptr);
+  }
+}
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef QMLON_ATOM_HH
+#define QMLON_ATOM_HH
+
+#include "qmlonstringref.h"
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace qmlon
+{
+  // Interned name, used for object types and property names. Each distinct
+  // name is stored once for the lifetime of the process, so atoms are
+  // compared by identity and ordered by an integer id instead of by their
+  // characters. Interning is thread-safe, and looking up a name that is
+  // already interned takes no lock.
+  class Atom
+  {
+  public:
+    // The empty name
+    Atom() : entry(&EMPTY) {}
+
+    // Interns the name
+    explicit Atom(StringRef name);
+
+    // Looks up an already interned name without interning it
+    static bool find(StringRef name, Atom& result);
+
+    std::uint32_t id() const { return entry->id; }
+    StringRef name() const { return entry->name; }
+    std::string str() const { return entry->name.str(); }
+    bool empty() const { return entry == &EMPTY; }
+
+    bool operator==(Atom const& other) const { return entry == other.entry; }
+    bool operator!=(Atom const& other) const { return entry != other.entry; }
+    bool operator<(Atom const& other) const { return entry->id < other.entry->id; }
+
+  private:
+    friend class AtomTable;
+    friend class AtomCache;
+
+    struct Entry
+    {
+      StringRef name;
+      std::uint32_t id;
+      std::size_t hash;
+    };
+
+    explicit Atom(Entry const* entry) : entry(entry) {}
+    static Entry const* intern(StringRef name, std::size_t hash);
+    static std::size_t hash(StringRef name);
+
+    static Entry const EMPTY;
+
+    Entry const* entry;
+  };
+
+  inline bool operator==(Atom const& a, StringRef const& b) { return a.name() == b; }
+  inline bool operator==(StringRef const& a, Atom const& b) { return a == b.name(); }
+  inline bool operator!=(Atom const& a, StringRef const& b) { return a.name() != b; }
+  inline bool operator!=(StringRef const& a, Atom const& b) { return a != b.name(); }
+
+  inline std::ostream& operator<<(std::ostream& out, Atom const& atom) { return out << atom.name(); }
+
+  // Small cache in front of the shared atom table for code that interns many
+  // names in a row, such as a parser. Repeated names are resolved without
+  // probing the shared table. Not thread-safe, use one per thread.
+  class AtomCache
+  {
+  public:
+    AtomCache();
+
+    Atom intern(StringRef name);
+
+  private:
+    static std::size_t const SIZE = 256;
+    Atom::Entry const* slots[SIZE];
+  };
+}
+
+#endif
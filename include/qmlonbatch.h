@@ -0,0 +1,62 @@
+#ifndef QMLON_BATCH_HH
+#define QMLON_BATCH_HH
+
+#include "qmlon.h"
+#include "qmlonschema.h"
+#include <exception>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace qmlon
+{
+  // Outcome of loading one file of a batch
+  struct LoadResult
+  {
+    std::string filename;
+
+    // Root of the document, or null if loading failed
+    Value::Reference root;
+
+    // Why loading failed, with the message of the exception
+    std::exception_ptr error;
+    std::string message;
+
+    bool ok() const { return !error; }
+  };
+
+  // Loads many files at once. Each file goes through a pipeline of reading,
+  // validating against an optional schema and an optional callback, such as
+  // one running an Initializer, on a pool of threads that take the next file
+  // as soon as they finish one. A file failing any stage does not affect the
+  // others. Reading the files is limited to a number of threads at a time,
+  // so that slow storage is not flooded with requests while the other
+  // threads parse and initialize what has been read.
+  class BatchLoader
+  {
+  public:
+    // Called on a worker thread for each document that was read and is
+    // valid. Exceptions thrown are reported as the failure of the file.
+    typedef std::function<void(std::string const& filename, Value::Reference const& root)> Callback;
+
+    // Zero threads means one per core, and zero readers no limit beyond the
+    // number of threads
+    BatchLoader(unsigned int threads = 0, unsigned int readers = 0);
+
+    // The schema must outlive the loader, and is used from several threads
+    void setSchema(Schema const* value) { schema = value; }
+    void setCallback(Callback const& value) { callback = value; }
+
+    // Results in the order of the files. Text and binary files are both
+    // accepted, and binary ones are read completely.
+    std::vector<LoadResult> load(std::vector<std::string> const& filenames) const;
+
+  private:
+    unsigned int threads;
+    unsigned int readers;
+    Schema const* schema;
+    Callback callback;
+  };
+}
+
+#endif
@@ -0,0 +1,59 @@
+#ifndef QMLON_BINARY_HH
+#define QMLON_BINARY_HH
+
+#include "qmlon.h"
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+namespace qmlon
+{
+  // Compiled QMLON documents. All numbers are little-endian and all offsets
+  // are from the start of the file.
+  //
+  //   Header  magic "\x89QML", version, file size, checksum (32-bit FNV-1a
+  //           of everything after the header), atom table offset, atom
+  //           count, root value offset and a reserved word: 8 x uint32
+  //   Value   uint32 type in the low 8 bits and, for property values, the
+  //           name atom in the high 24 bits, then uint64 data. Booleans,
+  //           integers and the bits of doubles are stored as the data.
+  //           Strings store their offset in the low and their length in the
+  //           high 32 bits, objects and lists their offset.
+  //   Object  uint32 type atom, property count and child count, then the
+  //           property values, then a uint32 offset per child
+  //   List    uint32 count, then the values
+  //   Atoms   uint32 offset and length per name. Atom 0 is the empty name.
+  //
+  // Strings are stored once each, anywhere in the file, and records are
+  // aligned to 4 bytes.
+  namespace binary
+  {
+    std::uint32_t const VERSION = 1;
+    std::size_t const HEADER_SIZE = 32;
+  }
+
+  // Whether a buffer starts like a binary document
+  bool isBinary(char const* data, std::size_t length);
+
+  void writeBinary(Value const& value, std::ostream& out);
+  std::string writeBinary(Value const& value);
+
+  // Reads a binary document without deserializing it. Objects are read from
+  // the source when they are first accessed and long strings refer to it
+  // directly, so memory mapped files are used in place. The checksum is
+  // only verified if verify is set. Throws if the document is corrupt or of
+  // an unsupported version.
+  Document::Reference readBinaryDocument(Source::Reference const& source, bool verify = true);
+  Value::Reference readBinary(Source::Reference const& source, bool verify = true);
+
+  // Reads a binary document embedded in the program by qmlon-embed. The
+  // data is used in place and was verified when it was embedded.
+  Value::Reference readEmbedded(char const* data, std::size_t length);
+
+  // Reads all objects of a value that have not been read yet, after which
+  // reading the value no longer modifies it and it can be shared between
+  // threads
+  void loadAll(Value const& value);
+}
+
+#endif
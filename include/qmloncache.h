@@ -0,0 +1,88 @@
+#ifndef QMLON_CACHE_HH
+#define QMLON_CACHE_HH
+
+#include "qmlon.h"
+#include <cstdint>
+#include <future>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace qmlon
+{
+  // Documents read from files, shared by everyone reading the same file. A
+  // cached document is used while the size and modification time of its
+  // file stay the same. With content hashing the file is also read and
+  // hashed on every request, which catches changes that do not show in the
+  // modification time, and a file that was only touched is not parsed
+  // again.
+  //
+  // Documents are read completely and their sources copied into memory
+  // before they are shared, so they can be read from several threads at
+  // once. They must not be modified. When the memory used by the cached
+  // documents exceeds the budget, the least recently used ones are dropped
+  // from the cache, and live on only as long as they are referenced.
+  //
+  // All functions are thread-safe. Requests for a file that is being read
+  // wait for that read instead of reading the file again.
+  class DocumentCache
+  {
+  public:
+    DocumentCache(std::size_t budget = 64 * 1024 * 1024, bool hashContent = false);
+    DocumentCache(DocumentCache const&) = delete;
+    DocumentCache& operator=(DocumentCache const&) = delete;
+
+    // Root of the document in a file, read if it is not cached or the file
+    // has changed. Text and binary files are both accepted. Throws if the
+    // file can not be read or parsed.
+    Value::Reference get(std::string const& filename);
+
+    void invalidate(std::string const& filename);
+    void clear();
+
+    // Number of cached documents, and the memory they use
+    std::size_t count() const;
+    std::size_t memoryUsage() const;
+
+    // Number of times a file has been parsed
+    std::size_t reads() const;
+
+  private:
+    struct Stamp
+    {
+      std::uint64_t size;
+      std::int64_t modified;
+
+      bool operator==(Stamp const& other) const { return size == other.size && modified == other.modified; }
+    };
+
+    struct Entry
+    {
+      Stamp stamp;
+      std::uint64_t hash;
+      Document::Reference document;
+      std::size_t size;
+      std::list<std::string>::iterator used;
+      std::shared_future<Value::Reference> root;
+    };
+
+    typedef std::map<std::string, std::shared_ptr<Entry>> Entries;
+
+    Value::Reference load(std::string const& filename, Stamp const& stamp, std::shared_ptr<Entry> const& previous, std::shared_ptr<Entry> const& entry);
+    void remove(Entries::iterator i);
+    void evict();
+
+    mutable std::mutex mutex;
+    std::size_t budget;
+    bool hashContent;
+    Entries entries;
+
+    // File names of the cached documents, most recently used first
+    std::list<std::string> used;
+    std::size_t usage;
+    std::size_t parsed;
+  };
+}
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef QMLON_HASH_HH
+#define QMLON_HASH_HH
+
+#include "qmlon.h"
+#include <cstdint>
+#include <unordered_map>
+
+namespace qmlon
+{
+  // Hash of a value by content, consistent with structurallyEqual
+  std::uint64_t structuralHash(Value const& value);
+
+  // Whether two values have the same content. Objects are equal if they
+  // have the same type, the same properties in the same order and equal
+  // children. Numbers are equal if they have the same type and bits, so
+  // 1 and 1.0 differ, and strings if they have the same bytes.
+  bool structurallyEqual(Value const& a, Value const& b);
+
+  // Hashes of values by content. Hashes of objects are remembered, so
+  // hashing a subtree and then its parts hashes each object once. The
+  // objects must not change while the hasher is in use.
+  class StructuralHasher
+  {
+  public:
+    std::uint64_t hash(Value const& value);
+    std::uint64_t hash(Object const& object);
+
+  private:
+    friend class ValueTable;
+
+    std::uint64_t content(Object const& object);
+
+    std::unordered_map<Object const*, std::uint64_t> objects;
+  };
+
+  // One shared instance of each distinct value, built from the leaves up.
+  // The objects and lists added must only contain shared instances, so
+  // that comparing two of them only compares their members by identity
+  // rather than comparing the subtrees.
+  class ValueTable
+  {
+  public:
+    std::uint64_t hash(Value const& value);
+
+    // The shared instance equal to the value, or null if there is none
+    Value const* find(Value const& value, std::uint64_t hash) const;
+
+    // Makes the value the shared instance of its content
+    void insert(Value const& value, std::uint64_t hash);
+
+  private:
+    StructuralHasher hasher;
+    std::unordered_multimap<std::uint64_t, Value> values;
+  };
+}
+
+#endif
@@ -3,6 +3,7 @@
 
 #include "qmlon.h"
 #include <type_traits>
+#include <functional>
 
 namespace qmlon
 {
@@ -23,32 +24,38 @@ template<class T>
                           std::map<std::string, std::function<void(T&, Value::Reference)>> propertySetters,
                           std::map<std::string, std::function<void(T&, Object&)>> childSetters);
   private:
-    std::map<std::string, std::function<void(T&, Value::Reference)>> propertySetters;
-    std::map<std::string, std::function<void(T&, Object&)>> childSetters;
+    // Names are resolved to atoms once here instead of comparing strings
+    // for every property and child
+    std::map<Atom, std::function<void(T&, Value::Reference)>> propertySetters;
+    std::map<Atom, std::function<void(T&, Object&)>> childSetters;
   };
 
   template<class T>
   Initializer<T>::Initializer(std::map<std::string, std::function<void(T&, Value::Reference)>> propertySetters,
                               std::map<std::string, std::function<void(T&, Object&)>> childSetters) :
-    propertySetters(propertySetters), childSetters(childSetters)
-  {}
-
-  template<class T>
-  void Initializer<T>::addPropertySetter(std::string const& name, std::function<void(T&, Value::Reference)> setter)
+    propertySetters(), childSetters()
   {
-    propertySetters[name] = setter;
+    for(auto const& setter : propertySetters)
+    {
+      addPropertySetter(setter.first, setter.second);
+    }
+
+    for(auto const& setter : childSetters)
+    {
+      addChildSetter(setter.first, setter.second);
+    }
   }
 
   template<class T>
-  void Initializer<T>::addChildSetter(std::string const& name, std::function<void(T&, Object&)> setter)
+  void Initializer<T>::addPropertySetter(std::string const& name, std::function<void(T&, Value::Reference)> setter)
   {
-    childSetters[name] = setter;
+    propertySetters[Atom(name)] = setter;
   }
 
   template<class T>
-  T& Initializer<T>::init(T& t, Object& obj)
+  void Initializer<T>::addChildSetter(std::string const& name, std::function<void(T&, Object&)> setter)
   {
-    return initialize(t, obj, propertySetters, childSetters);
+    childSetters[Atom(name)] = setter;
   }
 
   template<class T>
@@ -62,16 +69,22 @@ template<class T>
                 std::map<std::string, std::function<void(T&, Value::Reference)>> propertySetters,
                 std::map<std::string, std::function<void(T&, Object&)>> childSetters)
   {
-    for(auto keyValuePair : obj.properties)
+    return Initializer<T>(propertySetters, childSetters).init(t, obj);
+  }
+
+  template<class T>
+  T& Initializer<T>::init(T& t, Object& obj)
+  {
+    for(auto const& keyValuePair : obj.properties)
     {
       auto setter = propertySetters.find(keyValuePair.first);
       if(setter != propertySetters.end())
       {
-        (setter->second )(t, keyValuePair.second);
+        (setter->second )(t, unowned(&keyValuePair.second));
       }
     }
 
-    for(auto child : obj.children)
+    for(auto const& child : obj.children)
     {
       auto setter = childSetters.find(child->type);
       if(setter != childSetters.end())
@@ -80,7 +93,7 @@ template<class T>
       }
       else
       {
-        auto defaultSetter = childSetters.find("");
+        auto defaultSetter = childSetters.find(Atom());
         if(defaultSetter != childSetters.end())
         {
           (defaultSetter->second)(t, *child);
@@ -1,7 +1,11 @@
 #ifndef QMLON_LEXER
 #define QMLON_LEXER
+#include "qmlonstringref.h"
+#include "qmlonnumber.h"
 #include <string>
 #include <list>
+#include <memory>
+#include <vector>
 #include <istream>
 #include <stdexcept>
 
@@ -12,7 +16,7 @@ namespace qmlon
     OBJECT_START, OBJECT_END, LIST_START, LIST_END, 
     VALUE_SEPARATOR, KEY_VALUE_SEPARATOR, 
     INTEGER, FLOAT, BOOLEAN, IDENTIFIER, STRING,
-    UNKNOWN
+    UNKNOWN, END_OF_INPUT
   };
   
   struct StreamPosition
@@ -21,15 +25,36 @@ namespace qmlon
     unsigned int line;
     unsigned int lineCharacter;    
   };
+
+  // Position of a location given relative to origin
+  StreamPosition operator+(StreamPosition const& origin, StreamPosition const& relative);
   
+  // The content of a symbol is a view into the lexed buffer. The location of
+  // the symbol is only stored as the position of its content in the buffer,
+  // see Lexer::position for resolving it to a line and column. The digits of
+  // INTEGER and FLOAT symbols are decoded into number while lexing.
   struct Symbol
   {
     SymbolType type;
-    std::string content;
-    StreamPosition position;
+    StringRef content;
+    Number number;
+
+    // Whether a STRING symbol has escapes, which the lexer has checked
+    bool escaped;
   };
+
+  // Decodes the escapes of the content of a string symbol without its
+  // quotes into out, which needs room for as many bytes as the content.
+  // \uXXXX escapes, and surrogate pairs of them, are encoded as UTF-8.
+  // Returns the length of the decoded string.
+  std::size_t unescape(StringRef content, char* out);
   
-  typedef std::list<Symbol> SymbolSequence;
+  // Symbols of a stream lexed with lex(). The sequence keeps the source
+  // text alive so that the contents of the symbols remain valid.
+  struct SymbolSequence : public std::list<Symbol>
+  {
+    std::shared_ptr<std::string const> source;
+  };
   
   class SyntaxError : public std::runtime_error
   {
@@ -37,8 +62,97 @@ namespace qmlon
     SyntaxError(std::string const& message, StreamPosition position) : std::runtime_error(message), position(position) {}
     StreamPosition const position;
   };
+
+  // Resolves buffer offsets to line and column numbers. Line starts are only
+  // indexed as far as the largest offset resolved so far. Positions are
+  // reported relative to origin, the position of the start of the buffer.
+  class LineIndex
+  {
+  public:
+    LineIndex(char const* data, std::size_t length, StreamPosition origin = StreamPosition());
+    StreamPosition position(std::size_t offset);
+
+  private:
+    char const* data;
+    std::size_t length;
+    StreamPosition origin;
+    std::size_t indexed;
+    std::vector<std::size_t> lineStarts;
+  };
+
+  // Pull-based tokenizer. Symbols are produced one at a time as they are
+  // requested, so only the current symbol and one symbol of lookahead are
+  // kept in memory. The end of input is signaled with an END_OF_INPUT symbol.
+  //
+  // The lexer works over a contiguous buffer that must outlive the lexer and
+  // the symbols it produces. When constructed from a stream the whole stream
+  // is first read into a buffer owned by the lexer.
+  class Lexer
+  {
+  public:
+    Lexer(char const* data, std::size_t length, bool includeComments = false, bool includeWhitespace = false);
+    Lexer(char const* data, std::size_t length, StreamPosition origin, bool includeComments = false, bool includeWhitespace = false);
+    Lexer(std::istream& stream, bool includeComments = false, bool includeWhitespace = false);
+    Lexer(Lexer const&) = delete;
+    Lexer& operator=(Lexer const&) = delete;
+
+    // Returns the next symbol without consuming it
+    Symbol const& peek()
+    {
+      if(!primed)
+      {
+        advance(symbols[current]);
+        primed = true;
+      }
+
+      return symbols[current];
+    }
+
+    // Consumes and returns the next symbol. The returned reference stays
+    // valid until the following call to next().
+    Symbol const& next()
+    {
+      peek();
+      int previous = current;
+      current = 1 - current;
+      advance(symbols[current]);
+      return symbols[previous];
+    }
+
+    // Continues lexing at a position in the buffer, discarding the lookahead
+    void seek(char const* position) { cursor = position; primed = false; }
+
+    // Byte offset of a symbol produced by this lexer
+    std::size_t offset(Symbol const& symbol) const { return symbol.content.data() - begin; }
+
+    // Line and column of a symbol produced by this lexer
+    StreamPosition position(Symbol const& symbol);
+
+  private:
+    void advance(Symbol& symbol);
+    void readString(Symbol& symbol);
+    void readNumber(Symbol& symbol);
+    void readComment(Symbol& symbol);
+    void readIdentifierOrBoolean(Symbol& symbol);
+    void readWhitespace(Symbol& symbol);
+    SyntaxError error(char const* message, char const* at);
+
+    std::string buffer;
+    char const* begin;
+    char const* cursor;
+    char const* end;
+    LineIndex lines;
+    bool includeComments;
+    bool includeWhitespace;
+    Symbol symbols[2];
+    int current;
+    bool primed;
+  };
   
   SymbolSequence lex(std::istream& stream, bool includeComments = false, bool includeWhitespace = false);
+
+  // Reads the remaining contents of a stream into a string
+  std::string readAll(std::istream& stream);
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,36 @@
+#ifndef QMLON_NUMBER_HH
+#define QMLON_NUMBER_HH
+
+#include <cstdint>
+
+namespace qmlon
+{
+  // Decimal number as mantissa * 10^exponent. The mantissa holds the first
+  // 19 significant digits. Truncated is set if non-zero digits did not fit.
+  struct Number
+  {
+    std::uint64_t mantissa;
+    std::int32_t exponent;
+    bool negative;
+    bool isFloat;
+    bool truncated;
+  };
+
+  // Number conversion in the style of std::from_chars. Numbers are an
+  // optional minus sign followed by digits with at most one decimal point,
+  // and are read the same way regardless of the locale. Each function
+  // returns a pointer past the number, or first if [first, last) does not
+  // start with a number.
+  char const* scanNumber(char const* first, char const* last, Number& result);
+  char const* fromChars(char const* first, char const* last, std::int64_t& result);
+  char const* fromChars(char const* first, char const* last, double& result);
+
+  // Closest double to a scanned number. The text of the number is only read
+  // if digits were truncated and the result can not be decided without them.
+  double toDouble(Number const& number, char const* first, char const* last);
+
+  // Value of a scanned integer. Returns false if it does not fit.
+  bool toInt64(Number const& number, std::int64_t& result);
+}
+
+#endif
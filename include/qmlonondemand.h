@@ -0,0 +1,91 @@
+#ifndef QMLON_ONDEMAND_HH
+#define QMLON_ONDEMAND_HH
+
+#include "qmlon.h"
+#include "qmlonlexer.h"
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace qmlon
+{
+  // Brackets of a source. Each object and list is recorded as the offsets of
+  // its opening and closing bracket, ordered by the opening bracket, so that
+  // a reader can skip a subtree without lexing it. Brackets in strings and
+  // comments are ignored. Throws if the brackets are not balanced.
+  class StructuralIndex
+  {
+  public:
+    struct Span
+    {
+      std::uint32_t open;
+      std::uint32_t close;
+    };
+
+    StructuralIndex(char const* data, std::size_t length);
+
+    // Offset of the bracket closing the one at the given offset
+    std::size_t close(std::size_t open) const;
+
+    std::vector<Span> const& getSpans() const { return spans; }
+
+  private:
+    std::vector<Span> spans;
+  };
+
+  // Reads the content of deferred objects. Owned by their document.
+  class ObjectLoader
+  {
+  public:
+    virtual ~ObjectLoader() {}
+
+    // Reads the properties and children of an object. The position is the
+    // one the object was deferred with.
+    virtual void load(Object& object, std::size_t position) = 0;
+  };
+
+  // Reads the objects of a document on demand using the structural index of
+  // its source
+  class OnDemandReader : public ObjectLoader
+  {
+  public:
+    OnDemandReader(Document& document);
+
+    Value readRoot();
+
+    // Reads the properties and children of an object whose opening bracket
+    // is at the given offset. Nested objects are deferred in turn.
+    void load(Object& object, std::size_t open);
+
+  private:
+    Value readValue();
+    Value readList();
+    Object* defer(Atom type);
+    std::runtime_error error(char const* message, Symbol const& symbol);
+
+    Arena& arena;
+    char const* data;
+    StructuralIndex index;
+    Lexer lexer;
+    AtomCache atoms;
+  };
+
+  class DeferredObject
+  {
+  public:
+    // Defers the content of the object until its properties or children are
+    // first accessed
+    DeferredObject(ObjectLoader& loader, Object& object, std::size_t position);
+
+    // Reads the content of the object. If reading fails the object stays
+    // deferred and the next access throws again.
+    void load();
+
+  private:
+    ObjectLoader& loader;
+    Object& object;
+    std::size_t position;
+  };
+}
+
+#endif
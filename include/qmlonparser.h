@@ -0,0 +1,145 @@
+#ifndef QMLON_PARSER_HH
+#define QMLON_PARSER_HH
+
+#include "qmlon.h"
+#include "qmlonhash.h"
+#include "qmlonlexer.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace qmlon
+{
+  // Whether a symbol is an integer, float, boolean or string
+  inline bool isScalar(SymbolType type) { return type == INTEGER || type == FLOAT || type == BOOLEAN || type == STRING; }
+
+  // Value of a scalar symbol. Long strings without escapes refer to the
+  // content of the symbol. Strings with escapes are decoded into the buffer
+  // and refer to it, or into the arena. Without either the escapes are kept.
+  Value readScalar(Symbol const& symbol, std::string& buffer);
+  Value readScalar(Symbol const& symbol, Arena& arena);
+  Value readScalar(Symbol const& symbol);
+
+  // Recursive descent parser reporting the structure of one value of the
+  // buffer to a handler. Error positions are reported relative to origin,
+  // the position of the start of the buffer in a larger document.
+  class Parser
+  {
+  public:
+    Parser(char const* data, std::size_t length, Handler& handler, StreamPosition origin = StreamPosition());
+
+    void readValue();
+
+    // Reads properties and children up to the end of the buffer, as if they
+    // were the content of an object. Used to read parts of an object
+    // separately.
+    void readMembers();
+
+    // Throws unless only whitespace and comments are left in the buffer
+    void readEnd();
+
+  private:
+    void readList();
+    void readObject(Atom type);
+    void readMembers(SymbolType end);
+    std::runtime_error error(char const* message, Symbol const& symbol);
+
+    Handler& handler;
+    Lexer lexer;
+    AtomCache atoms;
+
+    // Strings with escapes are decoded here
+    std::string buffer;
+  };
+
+  // Handler building the values it receives into the arena of a document.
+  // Long strings keep referring to the source of the document, and are
+  // copied into the arena if they are not in it. Top-level values become
+  // the root of the document. Only the path from the root to the value
+  // being built is kept on a stack.
+  class DocumentBuilder : public Handler
+  {
+  public:
+    // With deduplicate, equal objects, lists and long strings are built
+    // once and shared, see readDocumentDeduplicated
+    DocumentBuilder(Document& document, bool deduplicate = false);
+
+    void onObjectStart(Atom type);
+    void onObjectEnd();
+    void onProperty(Atom name);
+    void onListStart();
+    void onListEnd();
+    void onValue(Value const& value);
+
+    // Innermost object being built, or null if it is a list or nothing is
+    // being built
+    Object* current() const { return stack.empty() ? nullptr : stack.back().object; }
+
+  private:
+    // An object or list being built. The property is the name of the
+    // property of the object whose value is expected next, if any.
+    // When deduplicating, the arena is marked where the object or list
+    // starts, so that it can be released if an equal one exists.
+    struct Frame
+    {
+      Object* object;
+      Value::List* list;
+      Atom property;
+      Arena::Mark mark;
+    };
+
+    void add(Value const& value);
+    void end();
+
+    Document& document;
+    Arena& arena;
+    std::vector<Frame> stack;
+    std::unique_ptr<ValueTable> shared;
+  };
+
+  // Push parser for documents that arrive in chunks. Each top-level value
+  // is handed to the callback as soon as its last byte has been fed, so only
+  // the text of the value currently being received is buffered. Chunks may
+  // split tokens, comments and strings at any byte.
+  class IncrementalParser
+  {
+  public:
+    typedef std::function<void(Value::Reference)> Callback;
+
+    IncrementalParser(Callback callback);
+
+    void feed(char const* data, std::size_t length);
+    void feed(std::string const& data) { feed(data.data(), data.length()); }
+
+    // Completes a value still pending at the end of input, for example a
+    // trailing number, and throws if the input ended in the middle of a value
+    void finish();
+
+  private:
+    enum LexicalState { CODE, STRING, STRING_ESCAPE, SLASH, LINE_COMMENT, BLOCK_COMMENT, BLOCK_COMMENT_STAR };
+    enum ValueState { BETWEEN_VALUES, WORD, AFTER_TYPE, STRING_VALUE, NESTED };
+
+    bool inValue() const { return valueState != BETWEEN_VALUES; }
+    void code(char c, std::size_t offset);
+    void startValue(std::size_t offset);
+    void completeValue();
+    StreamPosition positionAt(std::size_t offset);
+    SyntaxError error(char const* message, std::size_t offset);
+
+    Callback callback;
+    std::string buffer;
+    LexicalState lexicalState;
+    ValueState valueState;
+    unsigned int depth;
+
+    // The current chunk, and the position in the whole input of the chunk
+    // offset up to which positions have been resolved
+    char const* chunk;
+    std::size_t positionOffset;
+    StreamPosition position;
+    StreamPosition valuePosition;
+  };
+}
+
+#endif
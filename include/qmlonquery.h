@@ -0,0 +1,105 @@
+#ifndef QMLON_QUERY_HH
+#define QMLON_QUERY_HH
+
+#include "qmlon.h"
+#include "qmlonlexer.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace qmlon
+{
+  // Indexes of the children of objects by type, and by type and the value
+  // of a key property. The index of an object is built when a query first
+  // needs it, after which finding its children of a type, or the ones with
+  // a key value, takes constant time. The indexed objects must not be
+  // modified while the index is in use. Not thread-safe, use one per
+  // thread.
+  class ChildIndex
+  {
+  public:
+    typedef std::vector<Object*> Objects;
+
+    // Children of the type, in order
+    Objects const& byType(Object const& object, Atom type);
+
+    // Children of the type whose key property has the value, in order
+    Objects const& byKey(Object const& object, Atom type, Atom key, Value const& value);
+
+  private:
+    struct ValueHash
+    {
+      std::size_t operator()(Value const& value) const;
+    };
+
+    struct ValueEqual
+    {
+      bool operator()(Value const& a, Value const& b) const;
+    };
+
+    typedef std::unordered_map<Value, Objects, ValueHash, ValueEqual> Keys;
+
+    struct Entry
+    {
+      std::unordered_map<std::uint32_t, Objects> types;
+      std::unordered_map<std::uint64_t, Keys> keys;
+    };
+
+    Entry& entry(Object const& object);
+
+    std::unordered_map<Object const*, Entry> objects;
+  };
+
+  // Compiled path expression selecting descendants of an object. A path is
+  // a list of steps separated by slashes, each selecting children of the
+  // objects selected by the previous one. A step is a type, or * for
+  // children of any type, followed by any number of conditions on
+  // properties of the form [key=value]. Values are QMLON strings, numbers
+  // and booleans, and numbers match equal integers and floats. For example
+  //
+  //   Sprite[id="hero"]/Animation/Frame
+  //
+  // selects the frames of the animations of the sprite with the id "hero".
+  // Queries do not refer to any document, so one query can be run on many.
+  class Query
+  {
+  public:
+    // Throws a SyntaxError if the path is not valid
+    explicit Query(std::string const& path);
+
+    // Selected objects in the order they are in the document. With an
+    // index, steps with a type or a condition use it instead of going
+    // through all children.
+    std::vector<Object*> select(Object const& root, ChildIndex* index = nullptr) const;
+
+    // First selected object, or null if none is
+    Object* first(Object const& root, ChildIndex* index = nullptr) const;
+
+    std::string const& str() const { return path; }
+
+  private:
+    struct Condition
+    {
+      Atom key;
+      Value value;
+    };
+
+    struct Step
+    {
+      bool any;
+      Atom type;
+      std::vector<Condition> conditions;
+    };
+
+    void select(Object const& object, std::size_t step, ChildIndex* index, std::vector<Object*>& result, bool first) const;
+    bool matches(Object const& object, Step const& step, std::size_t from) const;
+
+    std::string path;
+    std::vector<Step> steps;
+
+    // Owns the strings of condition values
+    Document::Reference values;
+  };
+}
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef QMLON_RELOAD_HH
+#define QMLON_RELOAD_HH
+
+#include "qmlon.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace qmlon
+{
+  // A difference between two versions of a document. Objects are named by
+  // their path from the root, with child objects as Type[index] and values
+  // of properties by the name of the property, separated by slashes.
+  struct Change
+  {
+    enum Kind { ADDED, REMOVED, CHANGED };
+
+    Kind kind;
+    std::string path;
+
+    // The object before and after the change. For an added or removed
+    // property these are the object the property is in. An added object has
+    // no before and a removed one no after.
+    Object const* before;
+    Object const* after;
+
+    // Name of the property if the change is to a property
+    Atom property;
+  };
+
+  // Changes between two versions of a value. Object values of properties
+  // and children paired in order by type are compared member by member, and
+  // are otherwise reported as replaced. Subtrees that are the same object
+  // are skipped, so comparing versions from a Reloader only visits what was
+  // read again. Other values are compared by 64-bit hashes. Children
+  // inserted or removed at one place are reported once rather than shifting
+  // the index of the following ones.
+  std::vector<Change> diff(Value const& before, Value const& after);
+
+  // Rereads a document after edits to its text, reusing what the edits did
+  // not touch. The text that changed is found by comparing the versions,
+  // and only the innermost object enclosing it is parsed again. The other
+  // objects are shared with the previous version, whose root stays valid.
+  // Edits that are not inside the root object cause a full read, as does
+  // memory held by old versions growing beyond the size of the text.
+  class Reloader
+  {
+  public:
+    Reloader(Source::Reference const& source);
+
+    Value::Reference getRoot() { return document->getRoot(); }
+
+    // Reads the new version of the text and returns the changes to the
+    // document. Throws on syntax errors, keeping the previous version.
+    std::vector<Change> reload(Source::Reference const& source);
+
+    // Number of bytes parsed by the last reload
+    std::size_t getParsed() const { return parsed; }
+
+  private:
+    // An object of the document and its brackets in the text. Nodes are
+    // ordered by position, so the descendants of a node follow it, up to
+    // end.
+    struct Node
+    {
+      Object* object;
+      std::uint32_t open;
+      std::uint32_t close;
+      std::uint32_t end;
+      std::uint32_t parent;
+    };
+
+    void read(Source::Reference const& source);
+    bool update(Source::Reference const& source);
+
+    Source::Reference text;
+    Document::Reference document;
+    std::vector<Node> nodes;
+
+    // Memory held by earlier versions still referred to by the document
+    std::size_t retained;
+    std::size_t parsed;
+  };
+}
+
+#endif
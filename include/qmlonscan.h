@@ -0,0 +1,48 @@
+#ifndef QMLON_SCAN_HH
+#define QMLON_SCAN_HH
+
+namespace qmlon
+{
+  namespace scan
+  {
+    // Byte scanning kernels used by the lexer. Each function scans the range
+    // [p, end) and returns a pointer to the first match, or end if there is
+    // none.
+    struct Kernels
+    {
+      char const* name;
+
+      // First byte that is not a space, tab, carriage return or line feed
+      char const* (*skipWhitespace)(char const* p, char const* end);
+
+      // First carriage return or line feed
+      char const* (*findLineBreak)(char const* p, char const* end);
+
+      // First "*/" sequence, pointing to the asterisk
+      char const* (*findBlockCommentEnd)(char const* p, char const* end);
+
+      // First double quote or backslash
+      char const* (*findQuoteOrBackslash)(char const* p, char const* end);
+    };
+
+    // Kernel implementations. The vectorized variants return null if they
+    // are not supported by the build target or the running CPU.
+    Kernels const* scalarKernels();
+    Kernels const* sse2Kernels();
+    Kernels const* avx2Kernels();
+
+    // The fastest kernels supported by the running CPU, selected once
+    Kernels const& kernels();
+
+    inline char const* skipWhitespace(char const* p, char const* end) { return kernels().skipWhitespace(p, end); }
+    inline char const* findLineBreak(char const* p, char const* end) { return kernels().findLineBreak(p, end); }
+    inline char const* findBlockCommentEnd(char const* p, char const* end) { return kernels().findBlockCommentEnd(p, end); }
+    inline char const* findQuoteOrBackslash(char const* p, char const* end) { return kernels().findQuoteOrBackslash(p, end); }
+
+    // First bracket that is not in a string or comment. Strings and comments
+    // are skipped whole, so p must not be inside one.
+    char const* findBracket(char const* p, char const* end);
+  }
+}
+
+#endif
@@ -40,7 +40,7 @@ namespace qmlon
     {
     public:
       typedef std::shared_ptr<Value> Reference;
-      virtual bool validate(qmlon::Value::Reference const& value) const = 0;
+      virtual bool validate(qmlon::Value const& value) const = 0;
     };
 
     class Child
@@ -48,21 +48,21 @@ namespace qmlon
     public:
       Child(Schema* schema) : schema(schema),  min(0), max(0), type() {}
 
-      bool validate(qmlon::Object::Reference value) const;
+      bool validate(qmlon::Object const& value) const;
 
       Optional<int> getMin() const { return min; }
       Optional<int> getMax() const { return max; }
-      std::string getType() const { return type; }
+      Atom getType() const { return type; }
 
       void setMin(int value) { min = value; }
       void setMax(int value) { max = value; }
-      void setType(std::string value) { type = value; }
+      void setType(std::string value) { type = Atom(value); }
 
     private:
       Schema* schema;
       Optional<int> min;
       Optional<int> max;
-      std::string type;
+      Atom type;
     };
 
     class Property {
@@ -71,16 +71,16 @@ namespace qmlon
 
       bool validate(qmlon::Object const& value) const;
 
-      std::string getName() const { return name; }
+      Atom getName() const { return name; }
       Optional<bool> getOptional() const { return optional; }
       std::vector<Value::Reference> const& getValidTypes() const { return validTypes; }
 
-      void setName(std::string value) { name = value; }
+      void setName(std::string value) { name = Atom(value); }
       void setOptional(bool value) { optional = value; }
       void addValidType(Value::Reference value) { validTypes.push_back(value); }
 
     private:
-      std::string name;
+      Atom name;
       Optional<bool> optional;
       std::vector<Value::Reference> validTypes;
     };
@@ -92,18 +92,18 @@ namespace qmlon
 
       bool validate(qmlon::Object const& value) const;
 
-      std::string getType() const { return type; }
+      Atom getType() const { return type; }
       bool getIsInterface() const { return isInterface; }
       std::vector<Property> const& getProperties() const { return properties; }
       std::vector<Child> const& getChildren() const { return children; }
 
-      void setType(std::string value) { type = value; }
+      void setType(std::string value) { type = Atom(value); }
       void setIsInterface(bool value) { isInterface = value; }
       void addProperty(Property const& value) { properties.push_back(value); }
       void addChild(Child const& value) { children.push_back(value); }
 
     private:
-      std::string type;
+      Atom type;
       bool isInterface;
       std::vector<Property> properties;
       std::vector<Child> children;
@@ -113,7 +113,7 @@ namespace qmlon
     {
     public:
       BooleanValue() : Value() {}
-      virtual bool validate(qmlon::Value::Reference const& value) const;
+      virtual bool validate(qmlon::Value const& value) const;
     };
 
     class IntegerValue : public Value
@@ -121,7 +121,7 @@ namespace qmlon
     public:
       IntegerValue() : Value(), min(0), max(0) {}
 
-      virtual bool validate(qmlon::Value::Reference const& value) const;
+      virtual bool validate(qmlon::Value const& value) const;
 
       Optional<int> getMin() const { return min; }
       Optional<int> getMax() const { return max; }
@@ -139,7 +139,7 @@ namespace qmlon
     public:
       FloatValue() : Value(), min(0.0f), max(0.0f) {}
 
-      virtual bool validate(qmlon::Value::Reference const& value) const;
+      virtual bool validate(qmlon::Value const& value) const;
 
       Optional<float> getMin() const { return min; }
       Optional<float> getMax() const { return max; }
@@ -157,7 +157,7 @@ namespace qmlon
     public:
       StringValue() : Value(), min(0), max(0) {}
 
-      virtual bool validate(qmlon::Value::Reference const& value) const;
+      virtual bool validate(qmlon::Value const& value) const;
 
       Optional<int> getMin() const { return min; }
       Optional<int> getMax() const { return max; }
@@ -175,7 +175,7 @@ namespace qmlon
     public:
       ListValue() : Value(), validTypes(), min(0), max(0) {}
 
-      virtual bool validate(qmlon::Value::Reference const& value) const;
+      virtual bool validate(qmlon::Value const& value) const;
 
       Optional<std::vector<Value::Reference>> const& getValidTypes() const { return validTypes; }
       Optional<int> getMin() const { return min; }
@@ -196,27 +196,27 @@ namespace qmlon
     public:
       ObjectValue(Schema* schema) : Value(), schema(schema), type() {}
 
-      virtual bool validate(qmlon::Value::Reference const& value) const;
+      virtual bool validate(qmlon::Value const& value) const;
 
-      Optional<std::string> getType() const { return type; }
-      void setType(std::string value) { type = value; }
+      Optional<Atom> getType() const { return type; }
+      void setType(std::string value) { type = Atom(value); }
 
     private:
       Schema* schema;
-      Optional<std::string> type;
+      Optional<Atom> type;
     };
 
-    void setRoot(std::string const& value) { root = value; }
+    void setRoot(std::string const& value) { root = Atom(value); }
     void addObject(Object const& value) { objects[value.getType()] = value; }
 
-    std::string const& getRoot() const { return root; }
-    std::map<std::string, Object> const& getObjects() const { return objects; }
+    Atom getRoot() const { return root; }
+    std::map<Atom, Object> const& getObjects() const { return objects; }
 
     bool validate(qmlon::Value::Reference const& value) const;
 
   private:
-    std::string root;
-    std::map<std::string, Object> objects;
+    Atom root;
+    std::map<Atom, Object> objects;
 
   };
 }
@@ -0,0 +1,98 @@
+#ifndef QMLON_SNAPSHOT_HH
+#define QMLON_SNAPSHOT_HH
+
+#include "qmlon.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace qmlon
+{
+  // Immutable version of a document that any number of threads can read at
+  // once without locking. Everything read on demand is loaded when the
+  // snapshot is made, after which reading does not modify anything, and
+  // the snapshot is never modified. Child objects are held by references
+  // without reference counts, so going through them costs no atomic
+  // operations.
+  //
+  // Updates make a new snapshot, copying the objects from the root to the
+  // updated one and sharing everything else with this snapshot, which
+  // stays as it was. Each snapshot keeps the ones it was updated from
+  // alive; compact makes a copy that does not.
+  class Snapshot
+  {
+  public:
+    typedef std::shared_ptr<Snapshot const> Reference;
+
+    // Changes a copy of an object. The copy has the type, properties and
+    // children of the original, and values created for it must be owned by
+    // the given document, which is that of the new snapshot.
+    typedef std::function<void(Object& copy, Document& document)> Edit;
+
+    // Takes over a document, which must not be modified afterwards
+    static Reference create(Document::Reference const& document);
+
+    Value const& getRoot() const { return *root; }
+
+    // Reference to the root value that keeps the snapshot alive
+    Value::Reference getRootReference() const;
+
+    // New snapshot with an object of this one edited. Throws
+    // std::invalid_argument if the object is not part of this snapshot.
+    // The object is searched for through the whole snapshot.
+    Reference update(Object const& object, Edit const& edit) const;
+
+    // Same for the last object of a path of objects from the root, each
+    // directly in the one before it, which avoids the search
+    Reference update(std::vector<Object const*> const& path, Edit const& edit) const;
+
+    // New snapshot with a property of an object set. Strings are copied,
+    // other values must not refer to memory of other documents.
+    Reference setProperty(Object const& object, Atom name, Value const& value) const;
+
+    // New snapshot with a child of an object removed
+    Reference removeChild(Object const& object, Object const& child) const;
+
+    // Copy of this snapshot in a document of its own, releasing the
+    // versions it was updated from
+    Reference compact() const;
+
+  private:
+    Snapshot(Document::Reference const& document);
+
+    Document::Reference document;
+    Value const* root;
+  };
+
+  // The current snapshot of a document, for publishing updates to readers.
+  // Readers get the snapshot that is current when they ask for it and keep
+  // using it unaffected by updates published afterwards. Thread-safe, but
+  // not lock-free: get, set and update go through the atomic shared_ptr
+  // functions, which libstdc++ and libc++ implement with a short lock
+  // around the pointer copy. Readers take it once per get, so reading the
+  // snapshot they got takes no locks.
+  class SharedSnapshot
+  {
+  public:
+    SharedSnapshot(Snapshot::Reference const& initial) : current(initial) {}
+
+    Snapshot::Reference get() const { return std::atomic_load(&current); }
+    void set(Snapshot::Reference const& value) { std::atomic_store(&current, value); }
+
+    // Publishes an update of the current snapshot. If another update is
+    // published while this one is made, this one is made again on top of
+    // it. Returns the published snapshot.
+    Snapshot::Reference update(std::function<Snapshot::Reference(Snapshot const&)> const& f);
+
+  private:
+    Snapshot::Reference current;
+  };
+
+  // Copy of an object with every occurrence of an object among its values,
+  // the items of its lists and its children replaced, made in the arena.
+  // The copy shares everything else with the original.
+  Object* replace(Object const& object, Object const* from, Object* to, Arena& arena);
+  Value replace(Value const& value, Object const* from, Object* to, Arena& arena);
+}
+
+#endif
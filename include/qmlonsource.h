@@ -0,0 +1,46 @@
+#ifndef QMLON_SOURCE_HH
+#define QMLON_SOURCE_HH
+
+#include "qmlonstringref.h"
+#include <string>
+#include <istream>
+#include <memory>
+
+namespace qmlon
+{
+  // Immutable contiguous text of a QMLON document. Parsed values refer to
+  // the source text instead of copying it, and keep the source alive.
+  class Source
+  {
+  public:
+    typedef std::shared_ptr<Source const> Reference;
+
+    // Memory maps a regular file read-only. Files that cannot be mapped,
+    // such as pipes and other special files, are read into memory instead.
+    static Reference fromFile(std::string const& filename);
+    static Reference fromStream(std::istream& stream);
+    static Reference fromString(std::string str);
+
+    // Uses memory that outlives the source, such as static data, in place
+    static Reference fromMemory(char const* data, std::size_t length);
+
+    Source(Source const&) = delete;
+    Source& operator=(Source const&) = delete;
+    ~Source();
+
+    char const* data() const { return ptr; }
+    std::size_t length() const { return len; }
+    StringRef str() const { return StringRef(ptr, len); }
+    bool isMapped() const { return mapped; }
+
+  private:
+    Source();
+
+    std::string buffer;
+    char const* ptr;
+    std::size_t len;
+    bool mapped;
+  };
+}
+
+#endif
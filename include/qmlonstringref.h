@@ -0,0 +1,52 @@
+#ifndef QMLON_STRINGREF_HH
+#define QMLON_STRINGREF_HH
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <ostream>
+
+namespace qmlon
+{
+  // Non-owning view to a range of characters. The referred characters must
+  // outlive the view.
+  class StringRef
+  {
+  public:
+    constexpr StringRef() : ptr(nullptr), len(0) {}
+    constexpr StringRef(char const* data, std::size_t length) : ptr(data), len(length) {}
+    StringRef(char const* str) : ptr(str), len(std::strlen(str)) {}
+    StringRef(std::string const& str) : ptr(str.data()), len(str.length()) {}
+
+    char const* data() const { return ptr; }
+    std::size_t length() const { return len; }
+    std::size_t size() const { return len; }
+    bool empty() const { return len == 0; }
+
+    char const* begin() const { return ptr; }
+    char const* end() const { return ptr + len; }
+    char operator[](std::size_t i) const { return ptr[i]; }
+
+    StringRef substr(std::size_t pos, std::size_t n) const { return StringRef(ptr + pos, n); }
+    std::string str() const { return std::string(ptr, len); }
+
+    int compare(StringRef const& other) const
+    {
+      std::size_t n = len < other.len ? len : other.len;
+      int result = n ? std::memcmp(ptr, other.ptr, n) : 0;
+      return result != 0 ? result : (len < other.len ? -1 : (len > other.len ? 1 : 0));
+    }
+
+  private:
+    char const* ptr;
+    std::size_t len;
+  };
+
+  inline bool operator==(StringRef const& a, StringRef const& b) { return a.length() == b.length() && (a.length() == 0 || std::memcmp(a.data(), b.data(), a.length()) == 0); }
+  inline bool operator!=(StringRef const& a, StringRef const& b) { return !(a == b); }
+  inline bool operator<(StringRef const& a, StringRef const& b) { return a.compare(b) < 0; }
+
+  inline std::ostream& operator<<(std::ostream& out, StringRef const& s) { return out.write(s.data(), s.length()); }
+}
+
+#endif
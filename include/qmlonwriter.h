@@ -0,0 +1,60 @@
+#ifndef QMLON_WRITER_HH
+#define QMLON_WRITER_HH
+
+#include "qmlon.h"
+#include <ostream>
+#include <string>
+
+namespace qmlon
+{
+  // Writes values as QMLON text. Output is collected in a buffer and passed
+  // to the stream in large blocks. Strings are escaped and floats are
+  // written with the fewest digits that read back to the same double, so
+  // reading the output gives an equal document. Non-finite floats have no
+  // text form and throw.
+  class Writer
+  {
+  public:
+    // Compact output has no optional whitespace. Pretty output puts each
+    // property and child on its own line.
+    enum Mode { COMPACT, PRETTY };
+
+    Writer(std::ostream& out, Mode mode = PRETTY, int indent = 2);
+    Writer(Writer const&) = delete;
+    Writer& operator=(Writer const&) = delete;
+    ~Writer();
+
+    void write(Value const& value);
+
+    // Passes the buffered output to the stream
+    void flush();
+
+  private:
+    static std::size_t const BUFFER_SIZE = 64 * 1024;
+
+    void writeValue(Value const& value, int level);
+    void writeObject(Object const& object, int level);
+    void writeList(Value::List const& list, int level);
+    void writeString(StringRef value);
+    void writeInteger(std::int64_t value);
+    void writeFloat(double value);
+    void newline(int level);
+
+    // Called before each value and object, so that the buffer stays bounded
+    // in both modes
+    void flushIfFull() { if(buffer.size() >= BUFFER_SIZE) flush(); }
+
+    void put(char c) { buffer += c; }
+    void put(StringRef s) { buffer.append(s.data(), s.length()); }
+
+    std::ostream& out;
+    Mode mode;
+    int indent;
+    std::string buffer;
+  };
+
+  void writeText(Value const& value, std::ostream& out, Writer::Mode mode = Writer::PRETTY);
+  std::string writeText(Value const& value, Writer::Mode mode = Writer::PRETTY);
+}
+
+#endif
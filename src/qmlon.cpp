@@ -1,244 +1,561 @@
 #include "qmlon.h"
-#include "qmlonlexer.h"
+#include "qmlonparser.h"
+#include "qmlonbinary.h"
+#include "qmlonwriter.h"
+#include <algorithm>
 #include <cctype>
+#include <climits>
+#include <cstring>
 #include <sstream>
-#include <fstream>
-#include <iostream>
-namespace qmlon
+
+std::string qmlon::Value::str() const
 {
-  Value::Reference readValue(SymbolSequence& symbols);
-  Value::List readList(SymbolSequence& symbols);
-  Object::Reference readObject(SymbolSequence& symbols);
-  Object::Reference readObject(SymbolSequence& symbols, std::string const& type);
-  void printObject(Object& object, std::ostream& out = std::cout, int level = 0);
-  void printValue(Value const& value, std::ostream& out = std::cout, int level = 0);
+  return writeText(*this, Writer::PRETTY);
 }
 
+qmlon::Value qmlon::Value::createString(StringRef value)
+{
+  Value result(STRING);
+  if(value.length() <= INLINE_STRING_CAPACITY)
+  {
+    std::copy(value.begin(), value.end(), result.storage);
+    result.inlineLength = value.length();
+  }
+  else
+  {
+    if(value.length() > UINT32_MAX)
+    {
+      throw std::length_error("QMLON string values are limited to 4 GiB");
+    }
 
-std::string qmlon::Value::str() const
+    char const* data = value.data();
+    std::uint32_t length = value.length();
+    std::memcpy(result.storage, &data, sizeof(data));
+    std::memcpy(result.storage + sizeof(data), &length, sizeof(length));
+    result.inlineLength = EXTERNAL_STRING;
+  }
+  return result;
+}
+
+int qmlon::Value::asInteger() const
+{
+  std::int64_t value = asInt64();
+  if(value < INT_MIN || value > INT_MAX)
+  {
+    throw std::range_error("Invalid use of QMLON value. Integer does not fit in int!");
+  }
+  return static_cast<int>(value);
+}
+
+bool qmlon::Value::tryAsInteger(int& result) const
+{
+  std::int64_t value;
+  if(!tryAsInt64(value) || value < INT_MIN || value > INT_MAX)
+  {
+    return false;
+  }
+  result = static_cast<int>(value);
+  return true;
+}
+
+bool qmlon::Object::hasProperty(StringRef name) const
+{
+  Atom atom;
+  return Atom::find(name, atom) && hasProperty(atom);
+}
+
+qmlon::Value const* qmlon::Object::getProperty(Atom name) const
+{
+  Properties::const_iterator property = properties.find(name);
+  return property != properties.end() ? &property->second : nullptr;
+}
+
+qmlon::Value const* qmlon::Object::getProperty(StringRef name) const
+{
+  Atom atom;
+  return Atom::find(name, atom) ? getProperty(atom) : nullptr;
+}
+
+void qmlon::Object::setProperty(Atom name, Value const& value)
+{
+  auto result = properties.insert(Properties::value_type(name, value));
+  if(!result.second)
+  {
+    result.first->second = value;
+  }
+}
+
+std::pair<qmlon::Properties::iterator, bool> qmlon::Properties::insert(value_type const& value)
+{
+  load();
+  std::size_t i = position(value.first);
+  if(i != entries.size())
+  {
+    return std::make_pair(entries.begin() + i, false);
+  }
+
+  entries.push_back(value);
+  if(entries.size() > INDEX_THRESHOLD)
+  {
+    // Keep the index at most half full
+    if(index.size() < entries.size() * 2)
+    {
+      rebuildIndex();
+    }
+    else
+    {
+      addToIndex(i);
+    }
+  }
+
+  return std::make_pair(entries.begin() + i, true);
+}
+
+std::size_t qmlon::Properties::position(Atom name) const
+{
+  if(index.empty())
+  {
+    std::size_t i = 0;
+    while(i < entries.size() && entries[i].first != name)
+    {
+      ++i;
+    }
+    return i;
+  }
+
+  std::size_t mask = index.size() - 1;
+  for(std::size_t s = slot(name, mask); index[s]; s = (s + 1) & mask)
+  {
+    if(entries[index[s] - 1].first == name)
+    {
+      return index[s] - 1;
+    }
+  }
+
+  return entries.size();
+}
+
+void qmlon::Properties::addToIndex(std::size_t i)
+{
+  std::size_t mask = index.size() - 1;
+  std::size_t s = slot(entries[i].first, mask);
+  while(index[s])
+  {
+    s = (s + 1) & mask;
+  }
+  index[s] = i + 1;
+}
+
+void qmlon::Properties::rebuildIndex()
+{
+  std::size_t capacity = 2 * INDEX_THRESHOLD;
+  while(capacity < entries.size() * 4)
+  {
+    capacity *= 2;
+  }
+
+  index.assign(capacity, 0);
+  for(std::size_t i = 0; i < entries.size(); ++i)
+  {
+    addToIndex(i);
+  }
+}
+
+qmlon::Document::Document(Source::Reference const& source) :
+  source(source), arena(), root(nullptr), loader(), parts()
+{
+}
+
+qmlon::Document::Reference qmlon::Document::create(Source::Reference const& source)
+{
+  return Reference(new Document(source));
+}
+
+qmlon::Value::Reference qmlon::Document::getRoot()
+{
+  return Value::Reference(shared_from_this(), root);
+}
+
+qmlon::Value qmlon::Document::createString(StringRef value)
+{
+  return Value::createString(value.length() > Value::INLINE_STRING_CAPACITY ? arena.copy(value) : value);
+}
+
+qmlon::Object* qmlon::Document::createObject(Atom type)
+{
+  Object* object = arena.create<Object>(&arena);
+  object->type = type;
+  return object;
+}
+
+qmlon::Parser::Parser(char const* data, std::size_t length, Handler& handler, StreamPosition origin) :
+  handler(handler), lexer(data, length, origin)
+{
+}
+
+std::runtime_error qmlon::Parser::error(char const* message, Symbol const& symbol)
 {
   std::ostringstream ss;
-  printValue(*this, ss);
-  return ss.str();
+  StreamPosition position = lexer.position(symbol);
+  ss << "ERROR: " << message << " at line " << position.line + 1 << " character " << position.lineCharacter + 1;
+  return std::runtime_error(ss.str());
 }
 
-qmlon::Value::List qmlon::readList(SymbolSequence& symbols)
+void qmlon::Parser::readList()
 {
-  Symbol symbol = symbols.front();
-  if(symbol.type != LIST_START)
+  if(lexer.peek().type != LIST_START)
   {
-    std::ostringstream ss;
-    ss << "ERROR: Expected [ at line " << symbol.position.line + 1 << " character " << symbol.position.lineCharacter + 1;
-    throw std::runtime_error(ss.str());
+    throw error("Expected [", lexer.peek());
   }
 
-  symbols.pop_front();
-  Value::List list;
+  lexer.next();
+  handler.onListStart();
 
-  while(symbols.front().type != LIST_END)
+  while(lexer.peek().type != LIST_END)
   {
-    if(symbols.front().type == VALUE_SEPARATOR)
+    if(lexer.peek().type == VALUE_SEPARATOR)
     {
-      symbols.pop_front();
+      lexer.next();
     }
     
-    auto v = readValue(symbols);
-    list.push_back(v);
+    readValue();
   }
 
-  symbols.pop_front();
-  return list;
+  lexer.next();
+  handler.onListEnd();
+}
+
+void qmlon::parse(Source::Reference const& source, Handler& handler)
+{
+  Parser parser(source->data(), source->length(), handler);
+  parser.readValue();
+}
+
+void qmlon::parse(std::istream& stream, Handler& handler)
+{
+  parse(Source::fromStream(stream), handler);
+}
+
+void qmlon::parse(std::string const& str, Handler& handler)
+{
+  parse(Source::fromString(str), handler);
 }
 
 qmlon::Value::Reference qmlon::readValue(std::istream& stream)
 {
-  SymbolSequence symbols = lex(stream);
-  return readValue(symbols);
+  return readValue(Source::fromStream(stream));
 }
 
-qmlon::Value::Reference qmlon::readValue(SymbolSequence& symbols) 
+qmlon::Document::Reference qmlon::readDocument(Source::Reference const& source)
 {
-  Symbol symbol = symbols.front();
+  Document::Reference document = Document::create(source);
+  DocumentBuilder builder(*document);
+  parse(source, builder);
+  return document;
+}
+
+qmlon::Value::Reference qmlon::readValue(Source::Reference const& source)
+{
+  return readDocument(source)->getRoot();
+}
+
+qmlon::Document::Reference qmlon::readDocumentDeduplicated(Source::Reference const& source)
+{
+  Document::Reference document = Document::create(source);
+  DocumentBuilder builder(*document, true);
+  parse(source, builder);
+  return document;
+}
+
+qmlon::Value::Reference qmlon::readValueDeduplicated(Source::Reference const& source)
+{
+  return readDocumentDeduplicated(source)->getRoot();
+}
+
+void qmlon::Parser::readValue()
+{
+  Symbol const& symbol = lexer.peek();
   
-  if(symbol.type == IDENTIFIER || symbol.type == OBJECT_START)
+  if(symbol.type == IDENTIFIER)
+  {
+    readObject(atoms.intern(lexer.next().content));
+  }
+  else if(symbol.type == OBJECT_START)
   {
-    return Value::Reference(new ObjectValue(readObject(symbols)));
+    readObject(Atom());
   }
   else if(symbol.type == LIST_START)
   {
-    return Value::Reference(new ListValue(readList(symbols)));
+    readList();
   }
-  else if(symbol.type == INTEGER)
+  else if(isScalar(symbol.type))
   {
-    symbols.pop_front();
-    return Value::Reference(new IntegerValue(std::atoi(symbol.content.data())));
+    handler.onValue(readScalar(lexer.next(), buffer));
   }
-  else if(symbol.type == FLOAT)
+  else
   {
-    symbols.pop_front();
-    return Value::Reference(new FloatValue(std::atof(symbol.content.data())));
+    throw error("Invalid value", symbol);
   }
-  else if(symbol.type == BOOLEAN)
+}
+
+qmlon::Value qmlon::readScalar(Symbol const& symbol, std::string& buffer)
+{
+  if(symbol.type == STRING && symbol.escaped)
   {
-    symbols.pop_front();
-    return Value::Reference(new BooleanValue(symbol.content == "true"));
+    StringRef content = symbol.content.substr(1, symbol.content.length() - 2);
+    buffer.resize(content.length());
+    return Value::createString(StringRef(&buffer[0], unescape(content, &buffer[0])));
   }
-  else if(symbol.type == STRING)
+  return readScalar(symbol);
+}
+
+qmlon::Value qmlon::readScalar(Symbol const& symbol, Arena& arena)
+{
+  if(symbol.type == STRING && symbol.escaped)
   {
-    symbols.pop_front();
-    // Remove quotes from string value
-    std::string stringValue = symbol.content.substr(1, symbol.content.length() - 2);
-    return Value::Reference(new StringValue(stringValue));
+    // The decoded string is no longer than the content. Strings that fit
+    // in the value are decoded on the stack, others straight into the arena.
+    StringRef content = symbol.content.substr(1, symbol.content.length() - 2);
+    char small[Value::INLINE_STRING_CAPACITY];
+    char* out = content.length() <= sizeof(small) ? small : static_cast<char*>(arena.allocate(content.length(), 1));
+    return Value::createString(StringRef(out, unescape(content, out)));
+  }
+  return readScalar(symbol);
+}
+
+qmlon::Value qmlon::readScalar(Symbol const& symbol)
+{
+  if(symbol.type == INTEGER)
+  {
+    // The lexer has checked the range
+    std::int64_t value = 0;
+    toInt64(symbol.number, value);
+    return Value::createInteger(value);
+  }
+  else if(symbol.type == FLOAT)
+  {
+    return Value::createFloat(toDouble(symbol.number, symbol.content.begin(), symbol.content.end()));
+  }
+  else if(symbol.type == BOOLEAN)
+  {
+    return Value::createBoolean(symbol.content == "true");
   }
   else
   {
-    std::ostringstream ss;
-    ss << "ERROR: Invalid value at line " << symbol.position.line + 1 << " character " << symbol.position.lineCharacter + 1;
-    throw std::runtime_error(ss.str());
+    // Remove quotes from string value. Long strings keep referring to the
+    // source. Escapes are left as they are.
+    return Value::createString(symbol.content.substr(1, symbol.content.length() - 2));
   }
 }
 
 qmlon::Value::Reference qmlon::readValue(std::string const& str)
 {
-  std::istringstream ss(str);
-  return readValue(ss);
+  return readValue(Source::fromString(str));
 }
 
 qmlon::Value::Reference qmlon::readFile(std::string const& filename)
 {
-  std::ifstream ss(filename);
-  return readValue(ss);
+  Source::Reference source = Source::fromFile(filename);
+  return isBinary(source->data(), source->length()) ? readBinary(source) : readValue(source);
 }
 
-qmlon::Object::Reference qmlon::readObject(SymbolSequence& symbols)
+void qmlon::Parser::readObject(Atom type)
 {
-  std::string type;
-  Symbol symbol = symbols.front();
-  if(symbol.type == IDENTIFIER)
+  if(lexer.peek().type != OBJECT_START)
   {
-    type = symbol.content;
-    symbols.pop_front();
+    throw error("Expected {", lexer.peek());
   }
+  
+  // pop OBJECT_START
+  lexer.next();
+  handler.onObjectStart(type);
+  readMembers(OBJECT_END);
+  
+  // pop OBJECT_END
+  lexer.next();
+  handler.onObjectEnd();
+}
 
-  return readObject(symbols, type);
+void qmlon::Parser::readMembers()
+{
+  readMembers(END_OF_INPUT);
 }
 
-qmlon::Object::Reference qmlon::readObject(SymbolSequence& symbols, std::string const& type)
+void qmlon::Parser::readEnd()
 {
-  Symbol symbol = symbols.front();
-  
-  if(symbol.type != OBJECT_START)
+  if(lexer.peek().type != END_OF_INPUT)
   {
-    std::ostringstream ss;
-    ss << "ERROR: Expected { at line " << symbol.position.line + 1 << " character " << symbol.position.lineCharacter + 1;
-    throw std::runtime_error(ss.str());
+    throw error("Expected end of input", lexer.peek());
   }
-  
-  // pop OBJECT_START
-  symbols.pop_front();
-  
-  Object::Reference object(new Object);
-  object->type = type;
+}
 
-  while(symbols.front().type != OBJECT_END)
+void qmlon::Parser::readMembers(SymbolType end)
+{
+  while(lexer.peek().type != end)
   {
-    symbol = symbols.front();
-    
-    if(symbol.type == VALUE_SEPARATOR)
+    if(lexer.peek().type == VALUE_SEPARATOR)
     {
-      symbols.pop_front();
-      symbol = symbols.front();
+      lexer.next();
     }
     
+    Symbol const& symbol = lexer.peek();
+
     if(symbol.type == OBJECT_START)
     {
-      object->children.push_back(readObject(symbols, ""));
+      readObject(Atom());
     }
     else if(symbol.type == IDENTIFIER)
     {
-      Symbol identifierSymbol = symbols.front();
-      
-      // pop IDENTIFIER
-      symbols.pop_front();
-      symbol = symbols.front();
+      Atom identifier = atoms.intern(lexer.next().content);
+      Symbol const& next = lexer.peek();
       
-      if(symbol.type == KEY_VALUE_SEPARATOR)
+      if(next.type == KEY_VALUE_SEPARATOR)
       {
         // pop KEY_VALUE_SEPARATOR
-        symbols.pop_front();
-        object->properties[identifierSymbol.content] = readValue(symbols);
+        lexer.next();
+        handler.onProperty(identifier);
+        readValue();
       }
-      else if(symbol.type == OBJECT_START)
+      else if(next.type == OBJECT_START)
       {
-        object->children.push_back(readObject(symbols, identifierSymbol.content));
+        readObject(identifier);
       }
       else
       {
-        std::ostringstream ss;
-        ss << "ERROR: Expected property or child object at line " << symbol.position.line + 1 << " character " << symbol.position.lineCharacter + 1;
-        throw std::runtime_error(ss.str());
+        throw error("Expected property or child object", next);
       }
     }
+    else
+    {
+      throw error("Expected property or child object", symbol);
+    }
   }
-  
-  // pop OBJECT_END
-  symbols.pop_front();
+}
 
-  return object;
+qmlon::DocumentBuilder::DocumentBuilder(Document& document, bool deduplicate) :
+  document(document), arena(document.getArena()), stack(), shared(deduplicate ? new ValueTable() : nullptr)
+{
+}
+
+void qmlon::DocumentBuilder::onObjectStart(Atom type)
+{
+  Arena::Mark mark = arena.mark();
+  Object* object = arena.create<Object>(&arena);
+  object->type = type;
+  if(!shared)
+  {
+    add(Value::createObject(object));
+  }
+  stack.push_back(Frame{object, nullptr, Atom(), mark});
 }
 
+void qmlon::DocumentBuilder::onObjectEnd()
+{
+  end();
+}
 
-void qmlon::printObject(Object& object, std::ostream& out, int level)
+void qmlon::DocumentBuilder::onProperty(Atom name)
 {
-  out << object.type << " {" << std::endl;
+  stack.back().property = name;
+}
 
-  for(auto prop : object.properties)
+void qmlon::DocumentBuilder::onListStart()
+{
+  Arena::Mark mark = arena.mark();
+  Value::List* list = arena.create<Value::List>(&arena);
+  if(!shared)
   {
-    out << std::string(level + 1, ' ');
-    out << prop.first << ": ";
-    printValue(*prop.second, out, level + 1);
-    out << std::endl;
+    add(Value::createList(list));
   }
+  stack.push_back(Frame{nullptr, list, Atom(), mark});
+}
 
-  for(auto child : object.children)
+void qmlon::DocumentBuilder::onListEnd()
+{
+  end();
+}
+
+void qmlon::DocumentBuilder::onValue(Value const& value)
+{
+  // Long strings refer to the source, which the document owns, unless they
+  // were decoded from escapes
+  if(value.isString() && value.asStringRef().length() > Value::INLINE_STRING_CAPACITY)
   {
-    out << std::string(level + 1, ' ');
-    printObject(*child, out, level + 1);
-  }
+    Source const* source = document.getSource().get();
+    char const* data = value.asStringRef().data();
+    bool inSource = source && data >= source->data() && data < source->data() + source->length();
+
+    // All long strings are shared, so that equal objects and lists have
+    // the same ones and only compare them by content
+    if(shared)
+    {
+      std::uint64_t hash = shared->hash(value);
+      if(Value const* existing = shared->find(value, hash))
+      {
+        add(*existing);
+        return;
+      }
 
-  out << std::string(level, ' ') << "}" << std::endl;
+      Value string = inSource ? value : document.createString(value.asStringRef());
+      shared->insert(string, hash);
+      add(string);
+      return;
+    }
+
+    if(!inSource)
+    {
+      add(document.createString(value.asStringRef()));
+      return;
+    }
+  }
+  add(value);
 }
 
-void qmlon::printValue(Value const& value, std::ostream& out, int level)
+void qmlon::DocumentBuilder::end()
 {
-  if(value.isObject())
+  Frame frame = stack.back();
+  stack.pop_back();
+  if(!shared)
   {
-    printObject(value.asObject(), out, level);
+    return;
   }
-  else if(value.isBoolean())
+
+  // The members are shared already, so an equal object or list shares all
+  // of them and everything allocated for this one can be dropped
+  Value value = frame.object ? Value::createObject(frame.object) : Value::createList(frame.list);
+  std::uint64_t hash = shared->hash(value);
+  if(Value const* existing = shared->find(value, hash))
   {
-    out << value.asBoolean();
+    arena.release(frame.mark);
+    add(*existing);
+    return;
   }
-  else if(value.isInteger())
+
+  shared->insert(value, hash);
+  add(value);
+}
+
+void qmlon::DocumentBuilder::add(Value const& value)
+{
+  if(stack.empty())
   {
-    out << value.asInteger();
+    document.setRoot(value);
+    return;
   }
-  else if(value.isFloat())
+
+  Frame& frame = stack.back();
+  if(frame.list)
   {
-    out << value.asFloat();
+    frame.list->push_back(value);
   }
-  else if(value.isString())
+  else if(!frame.property.empty())
   {
-    out << '"' << value.asString() << '"';
+    frame.object->setProperty(frame.property, value);
+    frame.property = Atom();
   }
-  else if(value.isList())
+  else
   {
-    out << "[ ";
-    for(auto item : value.asList())
-    {
-      printValue(*item, out, level + 1);
-      out << " ";
-    }
-    out << "]" << std::endl;
+    frame.object->children.push_back(value.tryAsObject());
   }
 }
+
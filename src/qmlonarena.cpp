@@ -0,0 +1,73 @@
+#include "qmlonarena.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+  std::size_t const MIN_CHUNK_SIZE = 4 * 1024;
+  std::size_t const MAX_CHUNK_SIZE = 1024 * 1024;
+}
+
+qmlon::Arena::Arena() :
+  chunks(nullptr), cursor(nullptr), limit(nullptr), reserved(0)
+{
+}
+
+qmlon::Arena::~Arena()
+{
+  while(chunks)
+  {
+    Chunk* previous = chunks->previous;
+    std::free(chunks);
+    chunks = previous;
+  }
+}
+
+void qmlon::Arena::release(Mark const& mark)
+{
+  while(chunks != mark.chunks)
+  {
+    Chunk* previous = chunks->previous;
+    reserved -= chunks->size;
+    std::free(chunks);
+    chunks = previous;
+  }
+  cursor = mark.cursor;
+  limit = mark.limit;
+}
+
+void* qmlon::Arena::allocateChunk(std::size_t size, std::size_t alignment)
+{
+  // Chunks grow with the arena so that large documents need few of them
+  std::size_t chunkSize = reserved < MIN_CHUNK_SIZE ? MIN_CHUNK_SIZE : (reserved < MAX_CHUNK_SIZE ? reserved : MAX_CHUNK_SIZE);
+  std::size_t needed = sizeof(Chunk) + size + alignment;
+  if(chunkSize < needed)
+  {
+    chunkSize = needed;
+  }
+
+  Chunk* chunk = static_cast<Chunk*>(std::malloc(chunkSize));
+  if(!chunk)
+  {
+    throw std::bad_alloc();
+  }
+
+  chunk->previous = chunks;
+  chunk->size = chunkSize;
+  chunks = chunk;
+  reserved += chunkSize;
+
+  cursor = reinterpret_cast<char*>(chunk + 1);
+  limit = reinterpret_cast<char*>(chunk) + chunkSize;
+  return allocate(size, alignment);
+}
+
+qmlon::StringRef qmlon::Arena::copy(StringRef str)
+{
+  char* data = static_cast<char*>(allocate(str.length(), 1));
+  if(str.length())
+  {
+    std::memcpy(data, str.data(), str.length());
+  }
+  return StringRef(data, str.length());
+}
@@ -0,0 +1,188 @@
+#include "qmlonatom.h"
+#include "qmlonarena.h"
+#include <atomic>
+#include <mutex>
+#include <new>
+
+namespace
+{
+  std::uint64_t const FNV_OFFSET_BASIS = 14695981039346656037ull;
+  std::uint64_t const FNV_PRIME = 1099511628211ull;
+}
+
+qmlon::Atom::Entry const qmlon::Atom::EMPTY = {StringRef("", 0), 0, static_cast<std::size_t>(FNV_OFFSET_BASIS)};
+
+namespace qmlon
+{
+  // Open addressing hash table of all interned names. Entries and names are
+  // allocated from an arena and never move, so atoms can read them without
+  // locking. Lookups probe the current slot array without locking either.
+  // Only adding a name takes the lock. Growing the table publishes a new
+  // slot array and keeps the old one, so lookups still probing the old one
+  // stay valid and at worst miss names added since.
+  class AtomTable
+  {
+  public:
+    typedef Atom::Entry Entry;
+
+    AtomTable() : mutex(), arena(), slots(nullptr), count(1)
+    {
+      Slots* initial = createSlots(1024);
+      insert(initial, &Atom::EMPTY);
+      slots.store(initial, std::memory_order_release);
+    }
+
+    // Returns the entry of the name, or null if it has not been interned and
+    // create is false
+    Entry const* find(StringRef name, std::size_t hash, bool create)
+    {
+      Entry const* entry = probe(slots.load(std::memory_order_acquire), name, hash);
+      if(entry || !create)
+      {
+        return entry;
+      }
+
+      // Another thread may have added the name since the probe
+      std::lock_guard<std::mutex> lock(mutex);
+      entry = probe(slots.load(std::memory_order_relaxed), name, hash);
+      return entry ? entry : add(name, hash);
+    }
+
+  private:
+    struct Slots
+    {
+      std::size_t mask;
+      std::atomic<Entry const*>* entries;
+    };
+
+    static Entry const* probe(Slots const* table, StringRef name, std::size_t hash)
+    {
+      for(std::size_t i = hash & table->mask;; i = (i + 1) & table->mask)
+      {
+        Entry const* entry = table->entries[i].load(std::memory_order_acquire);
+        if(!entry)
+        {
+          return nullptr;
+        }
+        if(entry->hash == hash && entry->name == name)
+        {
+          return entry;
+        }
+      }
+    }
+
+    Slots* createSlots(std::size_t size)
+    {
+      Slots* table = arena.create<Slots>();
+      table->mask = size - 1;
+      table->entries = static_cast<std::atomic<Entry const*>*>(arena.allocate(size * sizeof(std::atomic<Entry const*>), alignof(std::atomic<Entry const*>)));
+      for(std::size_t i = 0; i < size; ++i)
+      {
+        new(&table->entries[i]) std::atomic<Entry const*>(nullptr);
+      }
+      return table;
+    }
+
+    // Called with the lock held
+    Entry const* add(StringRef name, std::size_t hash)
+    {
+      Entry* entry = arena.create<Entry>();
+      entry->name = arena.copy(name);
+      entry->id = count++;
+      entry->hash = hash;
+
+      Slots* table = const_cast<Slots*>(slots.load(std::memory_order_relaxed));
+      if(count * 2 > table->mask + 1)
+      {
+        Slots* grown = createSlots((table->mask + 1) * 2);
+        for(std::size_t i = 0; i <= table->mask; ++i)
+        {
+          if(Entry const* e = table->entries[i].load(std::memory_order_relaxed))
+          {
+            insert(grown, e);
+          }
+        }
+        insert(grown, entry);
+        slots.store(grown, std::memory_order_release);
+        return entry;
+      }
+
+      insert(table, entry);
+      return entry;
+    }
+
+    static void insert(Slots* table, Entry const* entry)
+    {
+      std::size_t i = entry->hash & table->mask;
+      while(table->entries[i].load(std::memory_order_relaxed))
+      {
+        i = (i + 1) & table->mask;
+      }
+      table->entries[i].store(entry, std::memory_order_release);
+    }
+
+    std::mutex mutex;
+    Arena arena;
+    std::atomic<Slots const*> slots;
+    std::uint32_t count;
+  };
+
+}
+
+namespace
+{
+  qmlon::AtomTable& table()
+  {
+    static qmlon::AtomTable instance;
+    return instance;
+  }
+}
+
+qmlon::Atom::Atom(StringRef name) :
+  entry(intern(name, hash(name)))
+{
+}
+
+bool qmlon::Atom::find(StringRef name, Atom& result)
+{
+  Entry const* entry = table().find(name, hash(name), false);
+  if(entry)
+  {
+    result = Atom(entry);
+  }
+  return entry != nullptr;
+}
+
+qmlon::Atom::Entry const* qmlon::Atom::intern(StringRef name, std::size_t hash)
+{
+  return table().find(name, hash, true);
+}
+
+std::size_t qmlon::Atom::hash(StringRef name)
+{
+  std::uint64_t h = FNV_OFFSET_BASIS;
+  for(char c : name)
+  {
+    h = (h ^ static_cast<unsigned char>(c)) * FNV_PRIME;
+  }
+  return static_cast<std::size_t>(h);
+}
+
+qmlon::AtomCache::AtomCache()
+{
+  for(Atom::Entry const*& slot : slots)
+  {
+    slot = &Atom::EMPTY;
+  }
+}
+
+qmlon::Atom qmlon::AtomCache::intern(StringRef name)
+{
+  std::size_t hash = Atom::hash(name);
+  Atom::Entry const*& slot = slots[hash % SIZE];
+  if(slot->hash != hash || slot->name != name)
+  {
+    slot = Atom::intern(name, hash);
+  }
+  return Atom(slot);
+}
@@ -0,0 +1,132 @@
+#include "qmlonbatch.h"
+#include "qmlonbinary.h"
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace
+{
+  // Lets a limited number of threads in at a time
+  class Gate
+  {
+  public:
+    Gate(unsigned int count) : mutex(), available(), count(count) {}
+
+    void lock()
+    {
+      std::unique_lock<std::mutex> guard(mutex);
+      available.wait(guard, [this]() { return count > 0; });
+      --count;
+    }
+
+    void unlock()
+    {
+      {
+        std::lock_guard<std::mutex> guard(mutex);
+        ++count;
+      }
+      available.notify_one();
+    }
+
+  private:
+    std::mutex mutex;
+    std::condition_variable available;
+    unsigned int count;
+  };
+
+  // The file is copied into memory so that the reads happen here rather than
+  // from page faults during parsing
+  qmlon::Source::Reference readSource(std::string const& filename)
+  {
+    std::ifstream stream(filename, std::ios::in | std::ios::binary);
+    if(!stream)
+    {
+      throw std::runtime_error("ERROR: Could not open file " + filename);
+    }
+    return qmlon::Source::fromStream(stream);
+  }
+}
+
+qmlon::BatchLoader::BatchLoader(unsigned int threads, unsigned int readers) :
+  threads(threads), readers(readers), schema(nullptr), callback()
+{
+  if(this->threads == 0)
+  {
+    this->threads = std::thread::hardware_concurrency();
+  }
+  if(this->threads == 0)
+  {
+    this->threads = 1;
+  }
+}
+
+std::vector<qmlon::LoadResult> qmlon::BatchLoader::load(std::vector<std::string> const& filenames) const
+{
+  std::vector<LoadResult> results(filenames.size());
+  std::size_t count = threads < filenames.size() ? threads : filenames.size();
+  Gate gate(readers == 0 || readers > count ? count : readers);
+  std::atomic<std::size_t> next(0);
+
+  auto work = [&]() {
+    for(std::size_t i = next++; i < filenames.size(); i = next++)
+    {
+      LoadResult& result = results[i];
+      result.filename = filenames[i];
+      try
+      {
+        Source::Reference source;
+        {
+          std::lock_guard<Gate> reading(gate);
+          source = readSource(filenames[i]);
+        }
+
+        Value::Reference root;
+        if(isBinary(source->data(), source->length()))
+        {
+          root = readBinary(source);
+          loadAll(*root);
+        }
+        else
+        {
+          root = readValue(source);
+        }
+
+        if(schema && !schema->validate(root))
+        {
+          throw std::runtime_error("ERROR: " + filenames[i] + " does not match the schema");
+        }
+        if(callback)
+        {
+          callback(filenames[i], root);
+        }
+        result.root = root;
+      }
+      catch(std::exception const& e)
+      {
+        result.error = std::current_exception();
+        result.message = e.what();
+      }
+      catch(...)
+      {
+        result.error = std::current_exception();
+        result.message = "ERROR: Unknown error";
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for(std::size_t i = 1; i < count; ++i)
+  {
+    workers.emplace_back(work);
+  }
+  work();
+  for(std::thread& worker : workers)
+  {
+    worker.join();
+  }
+
+  return results;
+}
@@ -0,0 +1,429 @@
+#include "qmlonbinary.h"
+#include "qmlonondemand.h"
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+  char const MAGIC[4] = {'\x89', 'Q', 'M', 'L'};
+  std::size_t const VALUE_SIZE = 12;
+  std::size_t const OBJECT_HEADER_SIZE = 12;
+  std::size_t const LIST_HEADER_SIZE = 4;
+  std::uint32_t const MAX_NAMES = 1 << 24;
+
+  std::uint32_t load32(char const* p)
+  {
+    unsigned char const* b = reinterpret_cast<unsigned char const*>(p);
+    return std::uint32_t(b[0]) | std::uint32_t(b[1]) << 8 | std::uint32_t(b[2]) << 16 | std::uint32_t(b[3]) << 24;
+  }
+
+  std::uint64_t load64(char const* p)
+  {
+    return std::uint64_t(load32(p)) | std::uint64_t(load32(p + 4)) << 32;
+  }
+
+  void store32(char* p, std::uint32_t value)
+  {
+    for(int i = 0; i < 4; ++i)
+    {
+      p[i] = static_cast<char>(value >> (8 * i));
+    }
+  }
+
+  void store64(char* p, std::uint64_t value)
+  {
+    store32(p, static_cast<std::uint32_t>(value));
+    store32(p + 4, static_cast<std::uint32_t>(value >> 32));
+  }
+
+  std::uint32_t checksum(char const* data, std::size_t length)
+  {
+    std::uint32_t hash = 2166136261u;
+    for(std::size_t i = 0; i < length; ++i)
+    {
+      hash = (hash ^ static_cast<unsigned char>(data[i])) * 16777619u;
+    }
+    return hash;
+  }
+
+  std::runtime_error corrupt()
+  {
+    return std::runtime_error("ERROR: Corrupt binary QMLON document");
+  }
+
+  class Writer
+  {
+  public:
+    Writer() : out(qmlon::binary::HEADER_SIZE, '\0'), atoms(), strings()
+    {
+      atom(qmlon::Atom());
+    }
+
+    std::string write(qmlon::Value const& root)
+    {
+      std::size_t rootOffset = reserve(VALUE_SIZE);
+      writeValue(root, rootOffset, 0);
+
+      std::vector<qmlon::Atom> table(atoms.size());
+      for(auto const& entry : atoms)
+      {
+        table[entry.second] = entry.first;
+      }
+
+      std::vector<std::uint32_t> names;
+      for(qmlon::Atom const& a : table)
+      {
+        names.push_back(string(a.name()));
+      }
+
+      std::size_t atomOffset = reserve(8 * table.size());
+      for(std::size_t i = 0; i < table.size(); ++i)
+      {
+        store32(&out[atomOffset + 8 * i], names[i]);
+        store32(&out[atomOffset + 8 * i + 4], table[i].name().length());
+      }
+
+      if(out.size() > UINT32_MAX)
+      {
+        throw std::length_error("Binary QMLON documents are limited to 4 GiB");
+      }
+
+      char* header = &out[0];
+      std::memcpy(header, MAGIC, sizeof(MAGIC));
+      store32(header + 4, qmlon::binary::VERSION);
+      store32(header + 8, out.size());
+      store32(header + 12, checksum(out.data() + qmlon::binary::HEADER_SIZE, out.size() - qmlon::binary::HEADER_SIZE));
+      store32(header + 16, atomOffset);
+      store32(header + 20, table.size());
+      store32(header + 24, rootOffset);
+      store32(header + 28, 0);
+      return std::move(out);
+    }
+
+  private:
+    // Appends zeroed space for a record aligned to 4 bytes
+    std::size_t reserve(std::size_t size)
+    {
+      std::size_t offset = (out.size() + 3) & ~std::size_t(3);
+      out.resize(offset + size, '\0');
+      return offset;
+    }
+
+    std::uint32_t atom(qmlon::Atom a)
+    {
+      auto result = atoms.insert(std::make_pair(a, std::uint32_t(atoms.size())));
+      if(atoms.size() > MAX_NAMES)
+      {
+        throw std::length_error("Binary QMLON documents are limited to 2^24 distinct names");
+      }
+      return result.first->second;
+    }
+
+    // The string must stay valid until the document has been written
+    std::uint32_t string(qmlon::StringRef s)
+    {
+      auto existing = strings.find(s);
+      if(existing != strings.end())
+      {
+        return existing->second;
+      }
+
+      std::uint32_t offset = out.size();
+      out.append(s.data(), s.length());
+      strings.insert(std::make_pair(s, offset));
+      return offset;
+    }
+
+    // Writes a value with the name of the property it is the value of
+    void writeValue(qmlon::Value const& value, std::size_t at, std::uint32_t name)
+    {
+      std::uint64_t b = 0;
+
+      switch(value.getType())
+      {
+        case qmlon::Value::BOOLEAN:
+          b = value.asBoolean();
+          break;
+
+        case qmlon::Value::INTEGER:
+          b = static_cast<std::uint64_t>(value.asInt64());
+          break;
+
+        case qmlon::Value::FLOAT:
+        {
+          double d = value.asDouble();
+          std::memcpy(&b, &d, sizeof(d));
+          break;
+        }
+
+        case qmlon::Value::STRING:
+          b = string(value.asStringRef()) | std::uint64_t(value.asStringRef().length()) << 32;
+          break;
+
+        case qmlon::Value::OBJECT:
+          b = writeObject(value.asObject());
+          break;
+
+        case qmlon::Value::LIST:
+          b = writeList(value.asList());
+          break;
+      }
+
+      store32(&out[at], value.getType() | name << 8);
+      store64(&out[at + 4], b);
+    }
+
+    std::size_t writeObject(qmlon::Object const& object)
+    {
+      std::size_t properties = object.properties.size();
+      std::size_t children = object.children.size();
+      std::size_t offset = reserve(OBJECT_HEADER_SIZE + VALUE_SIZE * properties + 4 * children);
+
+      store32(&out[offset], atom(object.type));
+      store32(&out[offset + 4], properties);
+      store32(&out[offset + 8], children);
+
+      std::size_t at = offset + OBJECT_HEADER_SIZE;
+      for(auto const& property : object.properties)
+      {
+        writeValue(property.second, at, atom(property.first));
+        at += VALUE_SIZE;
+      }
+
+      for(auto const& child : object.children)
+      {
+        std::size_t childOffset = writeObject(*child);
+        store32(&out[at], childOffset);
+        at += 4;
+      }
+
+      return offset;
+    }
+
+    std::size_t writeList(qmlon::Value::List const& list)
+    {
+      std::size_t offset = reserve(LIST_HEADER_SIZE + VALUE_SIZE * list.size());
+      store32(&out[offset], list.size());
+
+      std::size_t at = offset + LIST_HEADER_SIZE;
+      for(qmlon::Value const& item : list)
+      {
+        writeValue(item, at, 0);
+        at += VALUE_SIZE;
+      }
+
+      return offset;
+    }
+
+    std::string out;
+    std::map<qmlon::Atom, std::uint32_t> atoms;
+    std::map<qmlon::StringRef, std::uint32_t> strings;
+  };
+
+  // Reads values and objects from a binary document. Objects are deferred
+  // and loaded one at a time when they are accessed.
+  class Reader : public qmlon::ObjectLoader
+  {
+  public:
+    Reader(qmlon::Document& document, bool verify) :
+      arena(document.getArena()), data(document.getSource()->data()), size(document.getSource()->length()), atoms()
+    {
+      if(!qmlon::isBinary(data, size))
+      {
+        throw std::runtime_error("ERROR: Not a binary QMLON document");
+      }
+      else if(load32(data + 4) != qmlon::binary::VERSION)
+      {
+        throw std::runtime_error("ERROR: Unsupported binary QMLON version");
+      }
+      else if(load32(data + 8) != size)
+      {
+        throw corrupt();
+      }
+      else if(verify && load32(data + 12) != checksum(data + qmlon::binary::HEADER_SIZE, size - qmlon::binary::HEADER_SIZE))
+      {
+        throw std::runtime_error("ERROR: Binary QMLON document checksum mismatch");
+      }
+
+      std::size_t atomOffset = load32(data + 16);
+      std::size_t atomCount = load32(data + 20);
+      check(atomOffset, 8 * atomCount);
+
+      // Names are interned once per document instead of once per use
+      atoms.reserve(atomCount);
+      for(std::size_t i = 0; i < atomCount; ++i)
+      {
+        std::size_t offset = load32(data + atomOffset + 8 * i);
+        std::size_t length = load32(data + atomOffset + 8 * i + 4);
+        check(offset, length);
+        atoms.push_back(qmlon::Atom(qmlon::StringRef(data + offset, length)));
+      }
+    }
+
+    qmlon::Value readRoot()
+    {
+      std::size_t offset = load32(data + 24);
+      check(offset, VALUE_SIZE);
+      return readValue(offset);
+    }
+
+    void load(qmlon::Object& object, std::size_t offset)
+    {
+      std::size_t properties = load32(data + offset + 4);
+      std::size_t children = load32(data + offset + 8);
+      check(offset, OBJECT_HEADER_SIZE + VALUE_SIZE * properties + 4 * children);
+
+      char const* p = data + offset + OBJECT_HEADER_SIZE;
+      for(std::size_t i = 0; i < properties; ++i, p += VALUE_SIZE)
+      {
+        object.setProperty(atom(load32(p) >> 8), readValue(p - data));
+      }
+
+      for(std::size_t i = 0; i < children; ++i, p += 4)
+      {
+        object.children.push_back(defer(load32(p)));
+      }
+    }
+
+  private:
+    void check(std::size_t offset, std::size_t length) const
+    {
+      if(offset > size || length > size - offset)
+      {
+        throw corrupt();
+      }
+    }
+
+    qmlon::Atom atom(std::size_t index) const
+    {
+      if(index >= atoms.size())
+      {
+        throw corrupt();
+      }
+      return atoms[index];
+    }
+
+    qmlon::Value readValue(std::size_t at)
+    {
+      char const* p = data + at;
+      std::uint64_t b = load64(p + 4);
+
+      switch(static_cast<qmlon::Value::Type>(*p))
+      {
+        case qmlon::Value::BOOLEAN:
+          return qmlon::Value::createBoolean(b != 0);
+
+        case qmlon::Value::INTEGER:
+          return qmlon::Value::createInteger(static_cast<std::int64_t>(b));
+
+        case qmlon::Value::FLOAT:
+        {
+          double d;
+          std::memcpy(&d, &b, sizeof(d));
+          return qmlon::Value::createFloat(d);
+        }
+
+        case qmlon::Value::STRING:
+          check(b & 0xffffffff, b >> 32);
+          return qmlon::Value::createString(qmlon::StringRef(data + (b & 0xffffffff), b >> 32));
+
+        case qmlon::Value::OBJECT:
+          return qmlon::Value::createObject(defer(b));
+
+        case qmlon::Value::LIST:
+          return readList(b);
+      }
+
+      throw corrupt();
+    }
+
+    qmlon::Value readList(std::size_t offset)
+    {
+      check(offset, LIST_HEADER_SIZE);
+      std::size_t count = load32(data + offset);
+      check(offset, LIST_HEADER_SIZE + VALUE_SIZE * count);
+
+      qmlon::Value::List* list = arena.create<qmlon::Value::List>(&arena);
+      list->reserve(count);
+      for(std::size_t i = 0; i < count; ++i)
+      {
+        list->push_back(readValue(offset + LIST_HEADER_SIZE + VALUE_SIZE * i));
+      }
+
+      return qmlon::Value::createList(list);
+    }
+
+    qmlon::Object* defer(std::size_t offset)
+    {
+      check(offset, OBJECT_HEADER_SIZE);
+      qmlon::Object* object = arena.create<qmlon::Object>(&arena);
+      object->type = atom(load32(data + offset));
+      arena.create<qmlon::DeferredObject>(*this, *object, offset);
+      return object;
+    }
+
+    qmlon::Arena& arena;
+    char const* data;
+    std::size_t size;
+    std::vector<qmlon::Atom> atoms;
+  };
+}
+
+bool qmlon::isBinary(char const* data, std::size_t length)
+{
+  return length >= binary::HEADER_SIZE && std::memcmp(data, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+std::string qmlon::writeBinary(Value const& value)
+{
+  return Writer().write(value);
+}
+
+void qmlon::writeBinary(Value const& value, std::ostream& out)
+{
+  std::string data = writeBinary(value);
+  out.write(data.data(), data.size());
+}
+
+qmlon::Document::Reference qmlon::readBinaryDocument(Source::Reference const& source, bool verify)
+{
+  Document::Reference document = Document::create(source);
+  std::shared_ptr<Reader> reader = std::make_shared<Reader>(*document, verify);
+  document->setLoader(reader);
+  document->setRoot(reader->readRoot());
+  return document;
+}
+
+qmlon::Value::Reference qmlon::readBinary(Source::Reference const& source, bool verify)
+{
+  return readBinaryDocument(source, verify)->getRoot();
+}
+
+qmlon::Value::Reference qmlon::readEmbedded(char const* data, std::size_t length)
+{
+  return readBinary(Source::fromMemory(data, length), false);
+}
+
+void qmlon::loadAll(Value const& value)
+{
+  if(Object* object = value.tryAsObject())
+  {
+    for(auto const& property : object->properties)
+    {
+      loadAll(property.second);
+    }
+    for(auto const& child : object->children)
+    {
+      loadAll(Value::createObject(child));
+    }
+  }
+  else if(Value::List const* list = value.tryAsList())
+  {
+    for(Value const& item : *list)
+    {
+      loadAll(item);
+    }
+  }
+}
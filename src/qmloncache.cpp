@@ -0,0 +1,206 @@
+#include "qmloncache.h"
+#include "qmlonbinary.h"
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define QMLON_CACHE_STAT
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+  std::uint64_t hash(char const* data, std::size_t length)
+  {
+    std::uint64_t h = 14695981039346656037ull;
+    for(std::size_t i = 0; i < length; ++i)
+    {
+      h = (h ^ static_cast<unsigned char>(data[i])) * 1099511628211ull;
+    }
+    return h;
+  }
+}
+
+qmlon::DocumentCache::DocumentCache(std::size_t budget, bool hashContent) :
+  mutex(), budget(budget), hashContent(hashContent), entries(), used(), usage(0), parsed(0)
+{
+}
+
+qmlon::Value::Reference qmlon::DocumentCache::get(std::string const& filename)
+{
+  // Files that can not be examined never match and fail when read
+  Stamp stamp = {0, 0};
+#ifdef QMLON_CACHE_STAT
+  struct stat info;
+  if(stat(filename.c_str(), &info) == 0)
+  {
+#if defined(__APPLE__)
+    std::int64_t nanoseconds = info.st_mtimespec.tv_nsec;
+#else
+    std::int64_t nanoseconds = info.st_mtim.tv_nsec;
+#endif
+    stamp.size = info.st_size;
+    stamp.modified = std::int64_t(info.st_mtime) * 1000000000 + nanoseconds;
+  }
+#else
+  std::ifstream file(filename, std::ios::in | std::ios::binary | std::ios::ate);
+  stamp.size = file ? std::uint64_t(file.tellg()) : 0;
+#endif
+
+  std::unique_lock<std::mutex> lock(mutex);
+  std::shared_ptr<Entry> previous;
+  Entries::iterator i = entries.find(filename);
+  if(i != entries.end())
+  {
+    previous = i->second;
+    if(!previous->document)
+    {
+      // Already being read
+      std::shared_future<Value::Reference> root = previous->root;
+      lock.unlock();
+      return root.get();
+    }
+    else if(previous->stamp == stamp && !hashContent)
+    {
+      used.splice(used.begin(), used, previous->used);
+      return previous->document->getRoot();
+    }
+
+    remove(i);
+  }
+
+  std::promise<Value::Reference> promise;
+  std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+  entry->root = promise.get_future().share();
+  entries.insert(std::make_pair(filename, entry));
+  lock.unlock();
+
+  try
+  {
+    Value::Reference root = load(filename, stamp, previous, entry);
+    promise.set_value(root);
+    return root;
+  }
+  catch(...)
+  {
+    lock.lock();
+    i = entries.find(filename);
+    if(i != entries.end() && i->second == entry)
+    {
+      remove(i);
+    }
+    lock.unlock();
+
+    promise.set_exception(std::current_exception());
+    throw;
+  }
+}
+
+qmlon::Value::Reference qmlon::DocumentCache::load(std::string const& filename, Stamp const& stamp,
+                                                   std::shared_ptr<Entry> const& previous, std::shared_ptr<Entry> const& entry)
+{
+  // The file is copied into memory, as a mapped file changing on disk would
+  // change the document while it is in use
+  std::ifstream stream(filename, std::ios::in | std::ios::binary);
+  if(!stream)
+  {
+    throw std::runtime_error("ERROR: Could not open file " + filename);
+  }
+  Source::Reference source = Source::fromStream(stream);
+
+  std::uint64_t h = hashContent ? hash(source->data(), source->length()) : 0;
+  Document::Reference document;
+  if(hashContent && previous && previous->hash == h)
+  {
+    document = previous->document;
+  }
+  else if(isBinary(source->data(), source->length()))
+  {
+    document = readBinaryDocument(source);
+    loadAll(*document->getRoot());
+  }
+  else
+  {
+    document = readDocument(source);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  entry->stamp = stamp;
+  entry->hash = h;
+  entry->document = document;
+  entry->size = document->getSource()->length() + document->getArena().capacity();
+  if(document != (previous ? previous->document : nullptr))
+  {
+    ++parsed;
+  }
+
+  // The entry may have been invalidated while the file was read
+  Entries::iterator i = entries.find(filename);
+  if(i != entries.end() && i->second == entry)
+  {
+    used.push_front(filename);
+    entry->used = used.begin();
+    usage += entry->size;
+    evict();
+  }
+
+  return document->getRoot();
+}
+
+void qmlon::DocumentCache::remove(Entries::iterator i)
+{
+  // Entries being read are not counted yet
+  if(i->second->document)
+  {
+    used.erase(i->second->used);
+    usage -= i->second->size;
+  }
+  entries.erase(i);
+}
+
+void qmlon::DocumentCache::evict()
+{
+  // The most recently used document is kept even if it alone exceeds the
+  // budget
+  while(usage > budget && used.size() > 1)
+  {
+    remove(entries.find(used.back()));
+  }
+}
+
+void qmlon::DocumentCache::invalidate(std::string const& filename)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  Entries::iterator i = entries.find(filename);
+  if(i != entries.end())
+  {
+    remove(i);
+  }
+}
+
+void qmlon::DocumentCache::clear()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  while(!entries.empty())
+  {
+    remove(entries.begin());
+  }
+}
+
+std::size_t qmlon::DocumentCache::count() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return used.size();
+}
+
+std::size_t qmlon::DocumentCache::memoryUsage() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return usage;
+}
+
+std::size_t qmlon::DocumentCache::reads() const
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return parsed;
+}
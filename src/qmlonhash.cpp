@@ -0,0 +1,210 @@
+#include "qmlonhash.h"
+#include <cstring>
+
+namespace
+{
+  std::uint64_t combine(std::uint64_t h, std::uint64_t x)
+  {
+    x *= 0xff51afd7ed558ccdull;
+    x ^= x >> 33;
+    return (h ^ x) * 0x100000001b3ull;
+  }
+
+  std::uint64_t bits(double d)
+  {
+    std::uint64_t b;
+    std::memcpy(&b, &d, sizeof(d));
+    return b;
+  }
+
+  bool equal(qmlon::Object const& a, qmlon::Object const& b, bool deep);
+  bool equal(qmlon::Value::List const& a, qmlon::Value::List const& b, bool deep);
+
+  // Scalars are compared by content. Objects and lists are compared by
+  // identity, and by content too if deep is set.
+  bool equal(qmlon::Value const& a, qmlon::Value const& b, bool deep)
+  {
+    if(a.getType() != b.getType())
+    {
+      return false;
+    }
+
+    switch(a.getType())
+    {
+      case qmlon::Value::BOOLEAN:
+        return a.asBoolean() == b.asBoolean();
+      case qmlon::Value::INTEGER:
+        return a.asInt64() == b.asInt64();
+      case qmlon::Value::FLOAT:
+        return bits(a.asDouble()) == bits(b.asDouble());
+      case qmlon::Value::STRING:
+        return a.asStringRef() == b.asStringRef();
+      case qmlon::Value::OBJECT:
+        return &a.asObject() == &b.asObject() || (deep && equal(a.asObject(), b.asObject(), true));
+      case qmlon::Value::LIST:
+        return &a.asList() == &b.asList() || (deep && equal(a.asList(), b.asList(), true));
+    }
+    return false;
+  }
+
+  // Members are compared with equal for values
+  bool equal(qmlon::Object const& a, qmlon::Object const& b, bool deep)
+  {
+    if(a.type != b.type || a.properties.size() != b.properties.size() || a.children.size() != b.children.size())
+    {
+      return false;
+    }
+
+    for(auto i = a.properties.begin(), j = b.properties.begin(); i != a.properties.end(); ++i, ++j)
+    {
+      if(i->first != j->first || !equal(i->second, j->second, deep))
+      {
+        return false;
+      }
+    }
+    for(std::size_t i = 0; i < a.children.size(); ++i)
+    {
+      if(a.children[i] != b.children[i] && !(deep && equal(*a.children[i], *b.children[i], true)))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool equal(qmlon::Value::List const& a, qmlon::Value::List const& b, bool deep)
+  {
+    if(a.size() != b.size())
+    {
+      return false;
+    }
+    for(std::size_t i = 0; i < a.size(); ++i)
+    {
+      if(!equal(a[i], b[i], deep))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+std::uint64_t qmlon::structuralHash(Value const& value)
+{
+  return StructuralHasher().hash(value);
+}
+
+bool qmlon::structurallyEqual(Value const& a, Value const& b)
+{
+  return equal(a, b, true);
+}
+
+std::uint64_t qmlon::StructuralHasher::hash(Value const& value)
+{
+  std::uint64_t h = combine(14695981039346656037ull, value.getType());
+  switch(value.getType())
+  {
+    case Value::BOOLEAN:
+      return combine(h, value.asBoolean());
+
+    case Value::INTEGER:
+      return combine(h, static_cast<std::uint64_t>(value.asInt64()));
+
+    case Value::FLOAT:
+      return combine(h, bits(value.asDouble()));
+
+    case Value::STRING:
+      for(char c : value.asStringRef())
+      {
+        h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3ull;
+      }
+      return h;
+
+    case Value::OBJECT:
+      return hash(value.asObject());
+
+    case Value::LIST:
+      for(Value const& item : value.asList())
+      {
+        h = combine(h, hash(item));
+      }
+      return h;
+  }
+  return h;
+}
+
+std::uint64_t qmlon::StructuralHasher::hash(Object const& object)
+{
+  auto known = objects.find(&object);
+  if(known != objects.end())
+  {
+    return known->second;
+  }
+
+  std::uint64_t h = content(object);
+  objects.insert(std::make_pair(&object, h));
+  return h;
+}
+
+std::uint64_t qmlon::StructuralHasher::content(Object const& object)
+{
+  std::uint64_t h = combine(0, object.type.id());
+  for(auto const& property : object.properties)
+  {
+    h = combine(combine(h, property.first.id()), hash(property.second));
+  }
+  for(auto const& child : object.children)
+  {
+    h = combine(h, hash(*child));
+  }
+  return h;
+}
+
+std::uint64_t qmlon::ValueTable::hash(Value const& value)
+{
+  // The object is not remembered, as it may be dropped for a shared one
+  Object const* object = value.tryAsObject();
+  return object ? hasher.content(*object) : hasher.hash(value);
+}
+
+qmlon::Value const* qmlon::ValueTable::find(Value const& value, std::uint64_t hash) const
+{
+  auto range = values.equal_range(hash);
+  for(auto i = range.first; i != range.second; ++i)
+  {
+    Value const& candidate = i->second;
+    if(candidate.getType() != value.getType())
+    {
+      continue;
+    }
+
+    bool same = false;
+    if(value.isObject())
+    {
+      same = equal(value.asObject(), candidate.asObject(), false);
+    }
+    else if(value.isList())
+    {
+      same = equal(value.asList(), candidate.asList(), false);
+    }
+    else
+    {
+      same = equal(value, candidate, false);
+    }
+
+    if(same)
+    {
+      return &candidate;
+    }
+  }
+  return nullptr;
+}
+
+void qmlon::ValueTable::insert(Value const& value, std::uint64_t hash)
+{
+  if(Object const* object = value.tryAsObject())
+  {
+    hasher.objects[object] = hash;
+  }
+  values.insert(std::make_pair(hash, value));
+}
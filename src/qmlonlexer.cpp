@@ -1,273 +1,427 @@
 #include "qmlonlexer.h"
-#include <sstream>
+#include "qmlonscan.h"
+#include <cstring>
+#include <algorithm>
 
-class ContextStreamWrapper
+namespace
 {
-public:
-  ContextStreamWrapper(std::istream* stream);
-  explicit operator bool() const;
-  ContextStreamWrapper& get(char& c);
-  ContextStreamWrapper const& peek(char& c) const;
-  char get();
-  char peek() const;
-  
-  unsigned int currentPosition();
-  unsigned int currentLine();
-  unsigned int currentLinePosition();
-  
-private:
-  std::istream* stream;
-  unsigned int position;
-  unsigned int line;
-  unsigned int linePosition;
-};
-
-qmlon::SymbolSequence lex(ContextStreamWrapper& stream, bool includeComments, bool includeWhitespace);
-void readString(qmlon::Symbol& symbol, ContextStreamWrapper& stream);
-void readNumber(qmlon::Symbol& symbol, ContextStreamWrapper& stream);
-void readComment(qmlon::Symbol& symbol, ContextStreamWrapper& stream);
-void readIdentifierOrBoolean(qmlon::Symbol& symbol, ContextStreamWrapper& stream);
-void readWhitespace(qmlon::Symbol& symbol, ContextStreamWrapper& stream);
+  bool isWhitespace(char c)
+  {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+  }
 
-qmlon::SymbolSequence qmlon::lex(std::istream& stream, bool includeComments, bool includeWhitespace)
-{
-  ContextStreamWrapper wrapper(&stream);
-  return lex(wrapper, includeComments, includeWhitespace);
-}
+  bool isDigit(char c)
+  {
+    return c >= '0' && c <= '9';
+  }
 
-ContextStreamWrapper::ContextStreamWrapper(std::istream* stream) : stream(stream), position(0), line(0), linePosition(0) {}
-ContextStreamWrapper::operator bool() const
-{
-  return *stream && std::char_traits<char>::not_eof(peek());
+  bool isLetter(char c)
+  {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+  }
+
+  // Value of the four hex digits at p, or -1 if they are not all there
+  long readHex(char const* p, char const* end)
+  {
+    if(end - p < 4)
+    {
+      return -1;
+    }
+
+    long value = 0;
+    for(char const* q = p; q != p + 4; ++q)
+    {
+      char c = *q;
+      int digit = isDigit(c) ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+      if(digit < 0)
+      {
+        return -1;
+      }
+      value = value * 16 + digit;
+    }
+    return value;
+  }
+
+  // End of the escape at the backslash at p, or null if it is not valid.
+  // A high surrogate must be followed by an escaped low surrogate, and the
+  // pair is one escape.
+  char const* checkEscape(char const* p, char const* end)
+  {
+    if(end - p < 2)
+    {
+      return nullptr;
+    }
+
+    switch(p[1])
+    {
+      case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+        return p + 2;
+      case 'u':
+        break;
+      default:
+        return nullptr;
+    }
+
+    long code = readHex(p + 2, end);
+    if(code >= 0xd800 && code <= 0xdbff)
+    {
+      long low = end - p >= 12 && p[6] == '\\' && p[7] == 'u' ? readHex(p + 8, end) : -1;
+      return low >= 0xdc00 && low <= 0xdfff ? p + 12 : nullptr;
+    }
+    return code >= 0 && (code < 0xdc00 || code > 0xdfff) ? p + 6 : nullptr;
+  }
+
+  char* putUtf8(unsigned long code, char* out)
+  {
+    if(code < 0x80)
+    {
+      *out++ = static_cast<char>(code);
+    }
+    else if(code < 0x800)
+    {
+      *out++ = static_cast<char>(0xc0 | code >> 6);
+      *out++ = static_cast<char>(0x80 | (code & 0x3f));
+    }
+    else if(code < 0x10000)
+    {
+      *out++ = static_cast<char>(0xe0 | code >> 12);
+      *out++ = static_cast<char>(0x80 | (code >> 6 & 0x3f));
+      *out++ = static_cast<char>(0x80 | (code & 0x3f));
+    }
+    else
+    {
+      *out++ = static_cast<char>(0xf0 | code >> 18);
+      *out++ = static_cast<char>(0x80 | (code >> 12 & 0x3f));
+      *out++ = static_cast<char>(0x80 | (code >> 6 & 0x3f));
+      *out++ = static_cast<char>(0x80 | (code & 0x3f));
+    }
+    return out;
+  }
 }
-ContextStreamWrapper& ContextStreamWrapper::get(char& c)
+
+std::size_t qmlon::unescape(StringRef content, char* out)
 {
-  c = get();
-  return *this;
+  char const* p = content.begin();
+  char const* end = content.end();
+  char* start = out;
+
+  while(p != end)
+  {
+    char const* backslash = static_cast<char const*>(std::memchr(p, '\\', end - p));
+    if(backslash == nullptr)
+    {
+      backslash = end;
+    }
+    std::memcpy(out, p, backslash - p);
+    out += backslash - p;
+    if(backslash == end)
+    {
+      break;
+    }
+
+    char c = backslash[1];
+    p = backslash + 2;
+    switch(c)
+    {
+      case 'b': *out++ = '\b'; break;
+      case 'f': *out++ = '\f'; break;
+      case 'n': *out++ = '\n'; break;
+      case 'r': *out++ = '\r'; break;
+      case 't': *out++ = '\t'; break;
+      case 'u':
+      {
+        unsigned long code = readHex(p, end);
+        p += 4;
+        if(code >= 0xd800 && code <= 0xdbff)
+        {
+          code = 0x10000 + ((code - 0xd800) << 10) + (readHex(p + 2, end) - 0xdc00);
+          p += 6;
+        }
+        out = putUtf8(code, out);
+        break;
+      }
+      default: *out++ = c; break;
+    }
+  }
+
+  return out - start;
 }
-char ContextStreamWrapper::get()
+
+qmlon::SymbolSequence qmlon::lex(std::istream& stream, bool includeComments, bool includeWhitespace)
 {
-  char c = stream->get();
-  position += 1;
-  if(c == '\n')
+  SymbolSequence symbols;
+  symbols.source = std::make_shared<std::string>(readAll(stream));
+
+  Lexer lexer(symbols.source->data(), symbols.source->length(), includeComments, includeWhitespace);
+
+  while(lexer.peek().type != END_OF_INPUT)
   {
-    line += 1;
-    linePosition = 0;
+    symbols.push_back(lexer.next());
   }
-  else
+
+  return symbols;
+}
+
+std::string qmlon::readAll(std::istream& stream)
+{
+  std::string result;
+  char chunk[65536];
+
+  while(stream.read(chunk, sizeof(chunk)) || stream.gcount() > 0)
   {
-    linePosition += 1;
+    result.append(chunk, stream.gcount());
   }
-  
-  return c;
+
+  return result;
 }
-ContextStreamWrapper const& ContextStreamWrapper::peek(char& c) const
+
+qmlon::Lexer::Lexer(char const* data, std::size_t length, bool includeComments, bool includeWhitespace) :
+  buffer(), begin(data), cursor(data), end(data + length), lines(data, length),
+  includeComments(includeComments), includeWhitespace(includeWhitespace),
+  symbols(), current(0), primed(false)
 {
-  c = peek();
-  return *this;
 }
-char ContextStreamWrapper::peek() const
+
+qmlon::Lexer::Lexer(char const* data, std::size_t length, StreamPosition origin, bool includeComments, bool includeWhitespace) :
+  buffer(), begin(data), cursor(data), end(data + length), lines(data, length, origin),
+  includeComments(includeComments), includeWhitespace(includeWhitespace),
+  symbols(), current(0), primed(false)
 {
-  return stream->peek();
 }
 
-unsigned int ContextStreamWrapper::currentPosition()
+qmlon::Lexer::Lexer(std::istream& stream, bool includeComments, bool includeWhitespace) :
+  buffer(readAll(stream)), begin(buffer.data()), cursor(begin), end(begin + buffer.length()), lines(begin, buffer.length()),
+  includeComments(includeComments), includeWhitespace(includeWhitespace),
+  symbols(), current(0), primed(false)
 {
-  return position;
 }
-unsigned int ContextStreamWrapper::currentLine()
+
+qmlon::StreamPosition qmlon::Lexer::position(Symbol const& symbol)
 {
-  return line;
+  return lines.position(offset(symbol));
 }
 
-unsigned int ContextStreamWrapper::currentLinePosition()
+qmlon::SyntaxError qmlon::Lexer::error(char const* message, char const* at)
 {
-  return linePosition;
+  return SyntaxError(message, lines.position(at - begin));
 }
-  
-qmlon::SymbolSequence lex(ContextStreamWrapper& stream, bool includeComments, bool includeWhitespace)
+
+qmlon::StreamPosition qmlon::operator+(StreamPosition const& origin, StreamPosition const& relative)
 {
-  qmlon::SymbolSequence symbols;
-  
-  char c = '\0';
-  while(stream.peek(c))
+  return {origin.character + relative.character, origin.line + relative.line,
+    relative.line == 0 ? origin.lineCharacter + relative.lineCharacter : relative.lineCharacter};
+}
+
+qmlon::LineIndex::LineIndex(char const* data, std::size_t length, StreamPosition origin) :
+  data(data), length(length), origin(origin), indexed(0), lineStarts(1, 0)
+{
+}
+
+qmlon::StreamPosition qmlon::LineIndex::position(std::size_t offset)
+{
+  for(; indexed < offset && indexed < length; ++indexed)
   {
-    qmlon::Symbol symbol{qmlon::UNKNOWN, std::string(1, c), {stream.currentPosition(), stream.currentLine(), stream.currentLinePosition()}};
-    if(c == ' ' || c == '\t' || c == '\r' || c == '\n')
+    char const* lf = static_cast<char const*>(std::memchr(data + indexed, '\n', length - indexed));
+    if(lf == nullptr)
     {
-      readWhitespace(symbol, stream);
+      indexed = length;
+      break;
+    }
+
+    indexed = lf - data;
+    lineStarts.push_back(indexed + 1);
+  }
+
+  std::size_t line = std::upper_bound(lineStarts.begin(), lineStarts.end(), offset) - lineStarts.begin() - 1;
+  StreamPosition relative = {static_cast<unsigned int>(offset), static_cast<unsigned int>(line), static_cast<unsigned int>(offset - lineStarts[line])};
+  return origin + relative;
+}
+
+void qmlon::Lexer::advance(Symbol& symbol)
+{
+  while(cursor != end)
+  {
+    char c = *cursor;
+    char const* start = cursor;
+    symbol.type = UNKNOWN;
+    symbol.content = StringRef();
+
+    if(isWhitespace(c))
+    {
+      readWhitespace(symbol);
     }
     else if(c == '{')
     {
-      stream.get();
-      symbol.type = qmlon::OBJECT_START;
+      ++cursor;
+      symbol.type = OBJECT_START;
     }
     else if(c == '}')
     {
-      stream.get();
-      symbol.type = qmlon::OBJECT_END;
+      ++cursor;
+      symbol.type = OBJECT_END;
     }
     else if(c == '[')
     {
-      stream.get();
-      symbol.type = qmlon::LIST_START;
+      ++cursor;
+      symbol.type = LIST_START;
     }
     else if(c == ']')
     {
-      stream.get();
-      symbol.type = qmlon::LIST_END;
+      ++cursor;
+      symbol.type = LIST_END;
     }
     else if(c == ',')
     {
-      stream.get();
-      symbol.type = qmlon::VALUE_SEPARATOR;
+      ++cursor;
+      symbol.type = VALUE_SEPARATOR;
     }
     else if(c == ':')
     {
-      stream.get();
-      symbol.type = qmlon::KEY_VALUE_SEPARATOR;
+      ++cursor;
+      symbol.type = KEY_VALUE_SEPARATOR;
     }
-    else if((c >= '0' && c <= '9') || c == '.' || c == '-')
+    else if(isDigit(c) || c == '.' || c == '-')
     {
-      readNumber(symbol, stream);
+      readNumber(symbol);
     }
     else if(c == '"')
     {
-      readString(symbol, stream);
+      readString(symbol);
     }
-    else if((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+    else if(isLetter(c))
     {
-      readIdentifierOrBoolean(symbol, stream);
+      readIdentifierOrBoolean(symbol);
     }
     else if(c == '/')
     {
-      readComment(symbol, stream);
+      readComment(symbol);
     }
     
-    
-    if(symbol.type == qmlon::UNKNOWN)
+    if(symbol.type == UNKNOWN)
     {
-      throw qmlon::SyntaxError("Invalid syntax", symbol.position);
+      throw error("Invalid syntax", start);
     }
-    
-    if((includeComments || symbol.type != qmlon::LINE_COMMENT)
-      && (includeComments || symbol.type != qmlon::MULTILINE_COMMENT)
-      && (includeWhitespace || symbol.type != qmlon::WHITESPACE))
+
+    if(symbol.content.data() == nullptr)
+    {
+      symbol.content = StringRef(start, cursor - start);
+    }
+
+    if((includeComments || symbol.type != LINE_COMMENT)
+      && (includeComments || symbol.type != MULTILINE_COMMENT)
+      && (includeWhitespace || symbol.type != WHITESPACE))
     { 
-      symbols.push_back(symbol);
+      return;
     }
   }
-  
-  return symbols;
+
+  symbol.type = END_OF_INPUT;
+  symbol.content = StringRef(cursor, 0);
 }
 
-void readString(qmlon::Symbol& symbol, ContextStreamWrapper& stream)
+void qmlon::Lexer::readString(Symbol& symbol)
 {
-  symbol.type = qmlon::STRING;
-  char c = stream.get();
-  std::ostringstream ss;
-  ss << c;
-  
-  while(stream.get(c) && c != '"')
+  symbol.type = STRING;
+  symbol.escaped = false;
+  char const* start = cursor++;
+
+  for(;;)
   {
-    ss << c;
-    if(c == '\\')
+    cursor = scan::findQuoteOrBackslash(cursor, end);
+
+    if(cursor == end)
     {
-      stream.get();
+      throw error("Unterminated string", start);
     }
+    else if(*cursor == '"')
+    {
+      break;
+    }
+
+    // Escapes are only checked here, and decoded by readScalar
+    symbol.escaped = true;
+    char const* next = checkEscape(cursor, end);
+    if(next == nullptr)
+    {
+      throw error("Invalid escape", cursor);
+    }
+    cursor = next;
   }
 
-  ss << c;
-  symbol.content = ss.str();  
+  ++cursor;
 }
 
-void readNumber(qmlon::Symbol& symbol, ContextStreamWrapper& stream)
+void qmlon::Lexer::readNumber(Symbol& symbol)
 {
-  symbol.type = qmlon::INTEGER;
-  char c = stream.peek();
-  std::ostringstream ss;
-  
-  do
+  char const* start = cursor;
+  cursor = scanNumber(start, end, symbol.number);
+  std::int64_t integer;
+
+  if(cursor == start)
   {
-    if(c == '.')
-    {
-      if(symbol.type == qmlon::FLOAT)
-      {
-        throw qmlon::SyntaxError("Multiple decimal points in a float", symbol.position);
-      }
-      
-      symbol.type = qmlon::FLOAT;
-    }
-    ss << c;
-    stream.get();
-    c = stream.peek();
-  } while((c >= '0' && c <= '9') || c == '.');
-  
-  symbol.content = ss.str();
+    throw error("Invalid number", start);
+  }
+  else if(cursor != end && *cursor == '.')
+  {
+    throw error("Multiple decimal points in a float", start);
+  }
+  else if(!symbol.number.isFloat && !toInt64(symbol.number, integer))
+  {
+    throw error("Integer out of range", start);
+  }
+
+  symbol.type = symbol.number.isFloat ? FLOAT : INTEGER;
 }
 
-void readComment(qmlon::Symbol& symbol, ContextStreamWrapper& stream)
+void qmlon::Lexer::readComment(Symbol& symbol)
 {
-  char c = stream.get();
-  std::ostringstream ss;
-  ss << c;
-  c = stream.get();
+  char const* start = cursor;
+  ++cursor;
 
-  if(c == '/')
+  if(cursor != end && *cursor == '/')
   {
-    symbol.type = qmlon::LINE_COMMENT;
-    do
+    symbol.type = LINE_COMMENT;
+    cursor = scan::findLineBreak(cursor, end);
+
+    // The line break ending the comment is consumed but not included
+    symbol.content = StringRef(start, cursor - start);
+
+    if(cursor != end)
     {
-      ss << c;
-    } while(stream.get(c) && c != '\n' && c != '\r');
+      ++cursor;
+    }
   }
-  else if(c == '*')
+  else if(cursor != end && *cursor == '*')
   {
-    symbol.type = qmlon::MULTILINE_COMMENT;
-    bool previousWasAsterisk = false;
-    do
-    {
-      ss << c;
-      previousWasAsterisk = c == '*';
-    } while(stream.get(c) && !(previousWasAsterisk && c == '/'));
-    ss << c;
+    symbol.type = MULTILINE_COMMENT;
+    char const* next = scan::findBlockCommentEnd(cursor + 1, end);
+    cursor = next == end ? end : next + 2;
   }
-
-  symbol.content = ss.str();  
 }
 
-void readIdentifierOrBoolean(qmlon::Symbol& symbol, ContextStreamWrapper& stream)
+void qmlon::Lexer::readIdentifierOrBoolean(Symbol& symbol)
 {
-  char c = stream.peek();
-  std::ostringstream ss;
+  char const* start = cursor;
   
   do
   {
-    ss << stream.get();
-  } while(stream.peek(c) && ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')));
+    ++cursor;
+  } while(cursor != end && (isLetter(*cursor) || isDigit(*cursor)));
   
-  symbol.content = ss.str();
+  symbol.content = StringRef(start, cursor - start);
 
   if(symbol.content == "true" || symbol.content == "false")
   {
-    symbol.type = qmlon::BOOLEAN;
+    symbol.type = BOOLEAN;
   }
   else
   {
-    symbol.type = qmlon::IDENTIFIER;
+    symbol.type = IDENTIFIER;
   }
 }
 
-void readWhitespace(qmlon::Symbol& symbol, ContextStreamWrapper& stream)
+void qmlon::Lexer::readWhitespace(Symbol& symbol)
 {
-  symbol.type = qmlon::WHITESPACE;
-  char c = stream.peek();
-  std::ostringstream ss;
-  
-  do
-  {
-    ss << stream.get();
-  } while(stream.peek(c) && (c == ' ' || c == '\t' || c == '\r' || c == '\n'));
-  
-  symbol.content = ss.str();
+  symbol.type = WHITESPACE;
+  cursor = scan::skipWhitespace(cursor, end);
 }
@@ -0,0 +1,232 @@
+#include "qmlonondemand.h"
+#include "qmlonparser.h"
+#include "qmlonbinary.h"
+#include "qmlonscan.h"
+#include <algorithm>
+#include <sstream>
+
+qmlon::StructuralIndex::StructuralIndex(char const* data, std::size_t length) :
+  spans()
+{
+  if(length > UINT32_MAX)
+  {
+    throw std::length_error("QMLON documents read on demand are limited to 4 GiB");
+  }
+
+  // Positions in spans of the brackets not closed yet
+  std::vector<std::size_t> open;
+  char const* end = data + length;
+
+  for(char const* p = scan::findBracket(data, end); p != end; p = scan::findBracket(p + 1, end))
+  {
+    if(*p == '{' || *p == '[')
+    {
+      open.push_back(spans.size());
+      spans.push_back(Span{static_cast<std::uint32_t>(p - data), 0});
+    }
+    else
+    {
+      if(open.empty() || data[spans[open.back()].open] != (*p == '}' ? '{' : '['))
+      {
+        throw SyntaxError("Unbalanced brackets", LineIndex(data, length).position(p - data));
+      }
+      spans[open.back()].close = p - data;
+      open.pop_back();
+    }
+  }
+
+  if(!open.empty())
+  {
+    throw SyntaxError("Unclosed bracket", LineIndex(data, length).position(spans[open.back()].open));
+  }
+}
+
+std::size_t qmlon::StructuralIndex::close(std::size_t open) const
+{
+  auto span = std::lower_bound(spans.begin(), spans.end(), open, [](Span const& s, std::size_t offset) {
+    return s.open < offset;
+  });
+  return span->close;
+}
+
+qmlon::OnDemandReader::OnDemandReader(Document& document) :
+  arena(document.getArena()), data(document.getSource()->data()),
+  index(data, document.getSource()->length()), lexer(data, document.getSource()->length()), atoms()
+{
+}
+
+std::runtime_error qmlon::OnDemandReader::error(char const* message, Symbol const& symbol)
+{
+  std::ostringstream ss;
+  StreamPosition position = lexer.position(symbol);
+  ss << "ERROR: " << message << " at line " << position.line + 1 << " character " << position.lineCharacter + 1;
+  return std::runtime_error(ss.str());
+}
+
+qmlon::Value qmlon::OnDemandReader::readRoot()
+{
+  lexer.seek(data);
+  return readValue();
+}
+
+void qmlon::OnDemandReader::load(Object& object, std::size_t open)
+{
+  // Objects are only loaded by accessing them, never while reading another
+  // one, so the lexer is not in use
+  lexer.seek(data + open + 1);
+
+  while(lexer.peek().type != OBJECT_END)
+  {
+    if(lexer.peek().type == VALUE_SEPARATOR)
+    {
+      lexer.next();
+    }
+
+    Symbol const& symbol = lexer.peek();
+
+    if(symbol.type == OBJECT_START)
+    {
+      object.children.push_back(defer(Atom()));
+    }
+    else if(symbol.type == IDENTIFIER)
+    {
+      Atom identifier = atoms.intern(lexer.next().content);
+      Symbol const& next = lexer.peek();
+
+      if(next.type == KEY_VALUE_SEPARATOR)
+      {
+        lexer.next();
+        object.setProperty(identifier, readValue());
+      }
+      else if(next.type == OBJECT_START)
+      {
+        object.children.push_back(defer(identifier));
+      }
+      else
+      {
+        throw error("Expected property or child object", next);
+      }
+    }
+    else
+    {
+      throw error("Expected property or child object", symbol);
+    }
+  }
+}
+
+qmlon::Value qmlon::OnDemandReader::readValue()
+{
+  Symbol const& symbol = lexer.peek();
+
+  if(symbol.type == IDENTIFIER)
+  {
+    Atom type = atoms.intern(lexer.next().content);
+    return Value::createObject(defer(type));
+  }
+  else if(symbol.type == OBJECT_START)
+  {
+    return Value::createObject(defer(Atom()));
+  }
+  else if(symbol.type == LIST_START)
+  {
+    return readList();
+  }
+  else if(isScalar(symbol.type))
+  {
+    return readScalar(lexer.next(), arena);
+  }
+  else
+  {
+    throw error("Invalid value", symbol);
+  }
+}
+
+qmlon::Value qmlon::OnDemandReader::readList()
+{
+  lexer.next();
+  Value::List* list = arena.create<Value::List>(&arena);
+
+  while(lexer.peek().type != LIST_END)
+  {
+    if(lexer.peek().type == VALUE_SEPARATOR)
+    {
+      lexer.next();
+    }
+
+    list->push_back(readValue());
+  }
+
+  lexer.next();
+  return Value::createList(list);
+}
+
+qmlon::Object* qmlon::OnDemandReader::defer(Atom type)
+{
+  Symbol const& symbol = lexer.peek();
+  if(symbol.type != OBJECT_START)
+  {
+    throw error("Expected {", symbol);
+  }
+
+  std::size_t open = lexer.offset(symbol);
+  Object* object = arena.create<Object>(&arena);
+  object->type = type;
+  arena.create<DeferredObject>(*this, *object, open);
+
+  // Skip the content of the object
+  lexer.seek(data + index.close(open) + 1);
+  return object;
+}
+
+qmlon::DeferredObject::DeferredObject(ObjectLoader& loader, Object& object, std::size_t position) :
+  loader(loader), object(object), position(position)
+{
+  object.properties.deferred = this;
+  object.children.deferred = this;
+}
+
+void qmlon::DeferredObject::load()
+{
+  object.properties.deferred = nullptr;
+  object.children.deferred = nullptr;
+
+  try
+  {
+    loader.load(object, position);
+  }
+  catch(...)
+  {
+    object.properties.entries.clear();
+    object.properties.index.clear();
+    object.children.entries.clear();
+    object.properties.deferred = this;
+    object.children.deferred = this;
+    throw;
+  }
+}
+
+void qmlon::load(DeferredObject* deferred)
+{
+  deferred->load();
+}
+
+qmlon::Document::Reference qmlon::readDocumentOnDemand(Source::Reference const& source)
+{
+  Document::Reference document = Document::create(source);
+  std::shared_ptr<OnDemandReader> reader = std::make_shared<OnDemandReader>(*document);
+  document->setLoader(reader);
+  document->setRoot(reader->readRoot());
+  return document;
+}
+
+qmlon::Value::Reference qmlon::readValueOnDemand(Source::Reference const& source)
+{
+  return readDocumentOnDemand(source)->getRoot();
+}
+
+qmlon::Value::Reference qmlon::readFileOnDemand(std::string const& filename)
+{
+  // Binary documents are always read on demand
+  Source::Reference source = Source::fromFile(filename);
+  return isBinary(source->data(), source->length()) ? readBinary(source) : readValueOnDemand(source);
+}
@@ -0,0 +1,156 @@
+#include "qmlon.h"
+#include "qmlonparser.h"
+#include "qmlonbinary.h"
+#include "qmlonscan.h"
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  // Smaller documents are not worth starting threads for
+  std::size_t const MIN_PARALLEL_LENGTH = 256 * 1024;
+
+  // Slices per thread, so that threads finishing early can take more
+  unsigned int const SLICES_PER_THREAD = 4;
+
+  // Splits the content of the root object at the ends of its members. The
+  // root object is the first value of the source and must be an object. A
+  // member ending in a bracket ends where the bracket brings the depth back
+  // to the root, and the content is only split there. Returns false if the
+  // root is not an object or its brackets are not balanced.
+  bool split(char const* data, std::size_t length, std::size_t slices, qmlon::Atom& type, std::vector<std::size_t>& ends)
+  {
+    qmlon::Lexer lexer(data, length);
+    if(lexer.peek().type == qmlon::IDENTIFIER)
+    {
+      type = qmlon::Atom(lexer.next().content);
+    }
+
+    if(lexer.peek().type != qmlon::OBJECT_START)
+    {
+      return false;
+    }
+
+    char const* end = data + length;
+    char const* open = data + lexer.offset(lexer.peek());
+    std::size_t target = (length - (open - data)) / slices + 1;
+
+    ends.push_back(open + 1 - data);
+    unsigned int depth = 1;
+    for(char const* p = qmlon::scan::findBracket(open + 1, end); p != end; p = qmlon::scan::findBracket(p + 1, end))
+    {
+      if(*p == '{' || *p == '[')
+      {
+        ++depth;
+      }
+      else if(--depth == 0)
+      {
+        ends.push_back(p - data);
+        return true;
+      }
+      else if(depth == 1 && std::size_t(p + 1 - data) - ends.back() >= target)
+      {
+        ends.push_back(p + 1 - data);
+      }
+    }
+
+    return false;
+  }
+}
+
+qmlon::Document::Reference qmlon::readDocumentParallel(Source::Reference const& source, unsigned int threads)
+{
+  if(threads == 0)
+  {
+    threads = std::thread::hardware_concurrency();
+  }
+
+  Atom type;
+  std::vector<std::size_t> ends;
+  char const* data = source->data();
+  if(threads < 2 || source->length() < MIN_PARALLEL_LENGTH ||
+     !split(data, source->length(), threads * SLICES_PER_THREAD, type, ends) || ends.size() < 3)
+  {
+    return readDocument(source);
+  }
+
+  // Each slice is read into a document of its own, as arenas are not shared
+  // between threads
+  std::size_t count = ends.size() - 1;
+  std::vector<Document::Reference> parts(count);
+  std::vector<std::exception_ptr> errors(count);
+  std::atomic<std::size_t> next(0);
+
+  auto work = [&]() {
+    for(std::size_t i = next++; i < count; i = next++)
+    {
+      try
+      {
+        parts[i] = Document::create(source);
+        DocumentBuilder builder(*parts[i]);
+        Parser parser(data + ends[i], ends[i + 1] - ends[i], builder);
+        builder.onObjectStart(Atom());
+        parser.readMembers();
+        builder.onObjectEnd();
+      }
+      catch(...)
+      {
+        errors[i] = std::current_exception();
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for(unsigned int i = 1; i < threads && i < count; ++i)
+  {
+    workers.emplace_back(work);
+  }
+  work();
+  for(std::thread& worker : workers)
+  {
+    worker.join();
+  }
+
+  // Positions of errors are relative to the slice, so the document is read
+  // again in one piece to report them
+  for(std::exception_ptr const& error : errors)
+  {
+    if(error)
+    {
+      return readDocument(source);
+    }
+  }
+
+  Document::Reference document = Document::create(source);
+  Object* root = document->createObject(type);
+  for(Document::Reference const& part : parts)
+  {
+    Object& members = part->getRoot()->asObject();
+    for(auto const& property : members.properties)
+    {
+      root->setProperty(property.first, property.second);
+    }
+    for(Object* child : members.children)
+    {
+      root->children.push_back(child);
+    }
+    document->addPart(part);
+  }
+
+  document->setRoot(Value::createObject(root));
+  return document;
+}
+
+qmlon::Value::Reference qmlon::readValueParallel(Source::Reference const& source, unsigned int threads)
+{
+  return readDocumentParallel(source, threads)->getRoot();
+}
+
+qmlon::Value::Reference qmlon::readFileParallel(std::string const& filename, unsigned int threads)
+{
+  // Binary documents are read on demand, which needs no parsing
+  Source::Reference source = Source::fromFile(filename);
+  return isBinary(source->data(), source->length()) ? readBinary(source) : readValueParallel(source, threads);
+}
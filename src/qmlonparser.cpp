@@ -0,0 +1,321 @@
+#include "qmlonparser.h"
+#include "qmlonscan.h"
+#include <cstring>
+
+namespace
+{
+  bool isWhitespace(char c)
+  {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+  }
+
+  bool isDigit(char c)
+  {
+    return c >= '0' && c <= '9';
+  }
+
+  bool isLetter(char c)
+  {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+  }
+
+  bool isStructural(char c)
+  {
+    return c == '"' || c == '/' || c == '{' || c == '}' || c == '[' || c == ']';
+  }
+}
+
+qmlon::IncrementalParser::IncrementalParser(Callback callback) :
+  callback(callback), buffer(), lexicalState(CODE), valueState(BETWEEN_VALUES), depth(0),
+  chunk(nullptr), positionOffset(0), position(), valuePosition()
+{
+}
+
+void qmlon::IncrementalParser::feed(char const* data, std::size_t length)
+{
+  chunk = data;
+  positionOffset = 0;
+
+  char const* end = data + length;
+  std::size_t i = 0;
+
+  while(i < length)
+  {
+    // Consume runs of bytes that cannot change the state in bulk
+    char const* run = data + i;
+    if(lexicalState == STRING)
+    {
+      run = scan::findQuoteOrBackslash(run, end);
+    }
+    else if(lexicalState == LINE_COMMENT)
+    {
+      run = scan::findLineBreak(run, end);
+    }
+    else if(lexicalState == BLOCK_COMMENT)
+    {
+      char const* asterisk = static_cast<char const*>(std::memchr(run, '*', end - run));
+      run = asterisk ? asterisk : end;
+    }
+    else if(lexicalState == CODE && valueState == NESTED)
+    {
+      while(run != end && !isStructural(*run))
+        ++run;
+    }
+
+    if(inValue())
+    {
+      buffer.append(data + i, run);
+    }
+
+    i = run - data;
+    if(i == length)
+    {
+      break;
+    }
+
+    char c = data[i];
+    switch(lexicalState)
+    {
+      case CODE:
+        code(c, i);
+        break;
+
+      case STRING:
+        buffer += c;
+        if(c == '\\')
+        {
+          lexicalState = STRING_ESCAPE;
+        }
+        else
+        {
+          lexicalState = CODE;
+          if(valueState == STRING_VALUE)
+          {
+            completeValue();
+          }
+        }
+        break;
+
+      case STRING_ESCAPE:
+        buffer += c;
+        lexicalState = STRING;
+        break;
+
+      case SLASH:
+        if(inValue())
+        {
+          buffer += c;
+        }
+
+        if(c == '/')
+        {
+          lexicalState = LINE_COMMENT;
+        }
+        else if(c == '*')
+        {
+          lexicalState = BLOCK_COMMENT;
+        }
+        else
+        {
+          throw error("Invalid syntax", i);
+        }
+        break;
+
+      case LINE_COMMENT:
+        if(inValue())
+        {
+          buffer += c;
+        }
+        lexicalState = CODE;
+        break;
+
+      case BLOCK_COMMENT:
+      case BLOCK_COMMENT_STAR:
+        if(inValue())
+        {
+          buffer += c;
+        }
+
+        if(lexicalState == BLOCK_COMMENT_STAR && c == '/')
+        {
+          lexicalState = CODE;
+        }
+        else
+        {
+          lexicalState = c == '*' ? BLOCK_COMMENT_STAR : BLOCK_COMMENT;
+        }
+        break;
+    }
+
+    ++i;
+  }
+
+  positionAt(length);
+  chunk = nullptr;
+  positionOffset = 0;
+}
+
+void qmlon::IncrementalParser::finish()
+{
+  if(lexicalState == LINE_COMMENT && !inValue())
+  {
+    lexicalState = CODE;
+  }
+
+  if(lexicalState == CODE && valueState == WORD)
+  {
+    code(' ', positionOffset);
+  }
+
+  if(lexicalState != CODE || valueState != BETWEEN_VALUES)
+  {
+    throw error("Unexpected end of input", positionOffset);
+  }
+}
+
+void qmlon::IncrementalParser::code(char c, std::size_t offset)
+{
+  switch(valueState)
+  {
+    case BETWEEN_VALUES:
+      if(isWhitespace(c) || c == ',')
+      {
+        return;
+      }
+      else if(c == '/')
+      {
+        lexicalState = SLASH;
+        return;
+      }
+
+      if(c == '"')
+      {
+        lexicalState = STRING;
+        valueState = STRING_VALUE;
+      }
+      else if(c == '{' || c == '[')
+      {
+        depth = 1;
+        valueState = NESTED;
+      }
+      else if(isLetter(c) || isDigit(c) || c == '.' || c == '-')
+      {
+        valueState = WORD;
+      }
+      else
+      {
+        throw error("Invalid syntax", offset);
+      }
+
+      startValue(offset);
+      buffer += c;
+      break;
+
+    case WORD:
+      // Words follow the lexer: identifiers continue with letters and digits,
+      // numbers with digits and decimal points
+      if(isLetter(buffer[0]) ? isLetter(c) || isDigit(c) : isDigit(c) || c == '.')
+      {
+        buffer += c;
+      }
+      else if(isLetter(buffer[0]) && buffer != "true" && buffer != "false")
+      {
+        valueState = AFTER_TYPE;
+        code(c, offset);
+      }
+      else
+      {
+        completeValue();
+        code(c, offset);
+      }
+      break;
+
+    case AFTER_TYPE:
+      if(isWhitespace(c))
+      {
+        buffer += c;
+      }
+      else if(c == '/')
+      {
+        buffer += c;
+        lexicalState = SLASH;
+      }
+      else if(c == '{')
+      {
+        buffer += c;
+        depth = 1;
+        valueState = NESTED;
+      }
+      else
+      {
+        throw error("Expected {", offset);
+      }
+      break;
+
+    case STRING_VALUE:
+      // Completed by the closing quote in the lexical state machine
+      break;
+
+    case NESTED:
+      buffer += c;
+      if(c == '"')
+      {
+        lexicalState = STRING;
+      }
+      else if(c == '/')
+      {
+        lexicalState = SLASH;
+      }
+      else if(c == '{' || c == '[')
+      {
+        ++depth;
+      }
+      else if((c == '}' || c == ']') && --depth == 0)
+      {
+        completeValue();
+      }
+      break;
+  }
+}
+
+void qmlon::IncrementalParser::startValue(std::size_t offset)
+{
+  buffer.clear();
+  valuePosition = positionAt(offset);
+}
+
+void qmlon::IncrementalParser::completeValue()
+{
+  valueState = BETWEEN_VALUES;
+  Source::Reference source = Source::fromString(std::move(buffer));
+  buffer.clear();
+
+  Document::Reference document = Document::create(source);
+  DocumentBuilder builder(*document);
+  Parser parser(source->data(), source->length(), builder, valuePosition);
+  parser.readValue();
+  callback(document->getRoot());
+}
+
+qmlon::StreamPosition qmlon::IncrementalParser::positionAt(std::size_t offset)
+{
+  char const* from = chunk + positionOffset;
+  char const* to = chunk + offset;
+  StreamPosition relative = {static_cast<unsigned int>(to - from), 0, static_cast<unsigned int>(to - from)};
+
+  while(char const* lf = static_cast<char const*>(from != to ? std::memchr(from, '\n', to - from) : nullptr))
+  {
+    relative.line += 1;
+    relative.lineCharacter = to - lf - 1;
+    from = lf + 1;
+  }
+
+  position = position + relative;
+  positionOffset = offset;
+  return position;
+}
+
+qmlon::SyntaxError qmlon::IncrementalParser::error(char const* message, std::size_t offset)
+{
+  return SyntaxError(message, positionAt(offset));
+}
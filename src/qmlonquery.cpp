@@ -0,0 +1,283 @@
+#include "qmlonquery.h"
+#include "qmlonparser.h"
+#include <cstring>
+#include <sstream>
+
+namespace
+{
+  bool isLetter(char c)
+  {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+  }
+
+  bool isDigit(char c)
+  {
+    return c >= '0' && c <= '9';
+  }
+
+  // Equality of scalar values, with numbers compared by value
+  bool equal(qmlon::Value const& a, qmlon::Value const& b)
+  {
+    if(a.isString() && b.isString())
+    {
+      return a.asStringRef() == b.asStringRef();
+    }
+    else if(a.isBoolean() && b.isBoolean())
+    {
+      return a.asBoolean() == b.asBoolean();
+    }
+    else if(a.isInteger() && b.isInteger())
+    {
+      return a.asInt64() == b.asInt64();
+    }
+    else if(a.isFloat() && b.isFloat())
+    {
+      return a.asDouble() == b.asDouble();
+    }
+    return false;
+  }
+}
+
+std::size_t qmlon::ChildIndex::ValueHash::operator()(Value const& value) const
+{
+  std::size_t h = 14695981039346656037ull;
+  if(value.isString())
+  {
+    for(char c : value.asStringRef())
+    {
+      h = (h ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    }
+  }
+  else if(value.isBoolean())
+  {
+    h ^= value.asBoolean();
+  }
+  else if(value.isFloat())
+  {
+    // Integers hash like the equal floats. Zero is normalized so that -0.0
+    // hashes like 0.0.
+    double d = value.asDouble() + 0.0;
+    std::uint64_t bits;
+    std::memcpy(&bits, &d, sizeof(d));
+    h = (h ^ bits) * 1099511628211ull;
+  }
+  return h;
+}
+
+bool qmlon::ChildIndex::ValueEqual::operator()(Value const& a, Value const& b) const
+{
+  return equal(a, b);
+}
+
+qmlon::ChildIndex::Entry& qmlon::ChildIndex::entry(Object const& object)
+{
+  auto existing = objects.find(&object);
+  if(existing != objects.end())
+  {
+    return existing->second;
+  }
+
+  Entry& e = objects[&object];
+  for(auto const& child : object.children)
+  {
+    e.types[child->type.id()].push_back(child);
+  }
+  return e;
+}
+
+qmlon::ChildIndex::Objects const& qmlon::ChildIndex::byType(Object const& object, Atom type)
+{
+  static Objects const none;
+  Entry& e = entry(object);
+  auto i = e.types.find(type.id());
+  return i == e.types.end() ? none : i->second;
+}
+
+qmlon::ChildIndex::Objects const& qmlon::ChildIndex::byKey(Object const& object, Atom type, Atom key, Value const& value)
+{
+  static Objects const none;
+  Entry& e = entry(object);
+  std::uint64_t id = std::uint64_t(type.id()) << 32 | key.id();
+  auto i = e.keys.find(id);
+  if(i == e.keys.end())
+  {
+    Keys& keys = e.keys[id];
+    for(Object* child : byType(object, type))
+    {
+      auto property = child->properties.find(key);
+      if(property != child->properties.end() && !property->second.isObject() && !property->second.isList())
+      {
+        keys[property->second].push_back(child);
+      }
+    }
+    i = e.keys.find(id);
+  }
+
+  auto match = i->second.find(value);
+  return match == i->second.end() ? none : match->second;
+}
+
+qmlon::Query::Query(std::string const& path) :
+  path(path), steps(), values(Document::create())
+{
+  char const* begin = path.data();
+  char const* end = begin + path.length();
+  char const* p = begin;
+
+  auto error = [&](char const* message) {
+    std::ostringstream ss;
+    ss << "ERROR: " << message << " at character " << p - begin + 1 << " of query " << path;
+    StreamPosition position = {static_cast<unsigned int>(p - begin), 0, static_cast<unsigned int>(p - begin)};
+    return SyntaxError(ss.str(), position);
+  };
+
+  auto identifier = [&]() {
+    char const* start = p;
+    while(p != end && (isLetter(*p) || (p != start && isDigit(*p))))
+    {
+      ++p;
+    }
+    return Atom(StringRef(start, p - start));
+  };
+
+  for(;;)
+  {
+    Step step = {false, Atom(), {}};
+    if(p != end && *p == '*')
+    {
+      step.any = true;
+      ++p;
+    }
+    else if(p != end && isLetter(*p))
+    {
+      step.type = identifier();
+    }
+    else
+    {
+      throw error("Expected type or *");
+    }
+
+    while(p != end && *p == '[')
+    {
+      ++p;
+      if(p == end || !isLetter(*p))
+      {
+        throw error("Expected property name");
+      }
+
+      Condition condition = {identifier(), Value::createBoolean(false)};
+      if(p == end || *p != '=')
+      {
+        throw error("Expected =");
+      }
+      ++p;
+
+      Lexer lexer(p, end - p);
+      Symbol const& symbol = lexer.next();
+      if(!isScalar(symbol.type))
+      {
+        throw error("Expected string, number or boolean");
+      }
+
+      std::string decoded;
+      condition.value = readScalar(symbol, decoded);
+      if(condition.value.isString())
+      {
+        condition.value = values->createString(condition.value.asStringRef());
+      }
+      p += lexer.offset(symbol) + symbol.content.length();
+
+      if(p == end || *p != ']')
+      {
+        throw error("Expected ]");
+      }
+      ++p;
+      step.conditions.push_back(condition);
+    }
+
+    steps.push_back(step);
+    if(p == end)
+    {
+      break;
+    }
+    else if(*p != '/')
+    {
+      throw error("Expected / or [");
+    }
+    ++p;
+  }
+}
+
+std::vector<qmlon::Object*> qmlon::Query::select(Object const& root, ChildIndex* index) const
+{
+  std::vector<Object*> result;
+  select(root, 0, index, result, false);
+  return result;
+}
+
+qmlon::Object* qmlon::Query::first(Object const& root, ChildIndex* index) const
+{
+  std::vector<Object*> result;
+  select(root, 0, index, result, true);
+  return result.empty() ? nullptr : result.front();
+}
+
+void qmlon::Query::select(Object const& object, std::size_t i, ChildIndex* index, std::vector<Object*>& result, bool first) const
+{
+  Step const& step = steps[i];
+  bool last = i + 1 == steps.size();
+
+  auto visit = [&](Object* child, std::size_t from) {
+    if(matches(*child, step, from))
+    {
+      if(last)
+      {
+        result.push_back(child);
+      }
+      else
+      {
+        select(*child, i + 1, index, result, first);
+      }
+    }
+    return first && !result.empty();
+  };
+
+  if(index && !step.any)
+  {
+    // The index has already checked the type and the first condition
+    bool keyed = !step.conditions.empty();
+    Condition const* condition = keyed ? &step.conditions.front() : nullptr;
+    ChildIndex::Objects const& children = keyed ?
+      index->byKey(object, step.type, condition->key, condition->value) : index->byType(object, step.type);
+    for(Object* child : children)
+    {
+      if(visit(child, keyed ? 1 : 0))
+      {
+        return;
+      }
+    }
+  }
+  else
+  {
+    for(auto const& child : object.children)
+    {
+      if((step.any || child->type == step.type) && visit(child, 0))
+      {
+        return;
+      }
+    }
+  }
+}
+
+bool qmlon::Query::matches(Object const& object, Step const& step, std::size_t from) const
+{
+  for(std::size_t i = from; i < step.conditions.size(); ++i)
+  {
+    auto property = object.properties.find(step.conditions[i].key);
+    if(property == object.properties.end() || !equal(property->second, step.conditions[i].value))
+    {
+      return false;
+    }
+  }
+  return true;
+}
@@ -0,0 +1,416 @@
+#include "qmlonreload.h"
+#include "qmlonhash.h"
+#include "qmlonparser.h"
+#include "qmlonondemand.h"
+#include "qmlonsnapshot.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace
+{
+  std::uint32_t const NONE = UINT32_MAX;
+
+  // Memory that old versions may hold before the document is read again in
+  // full, unless the text is larger
+  std::size_t const MIN_RETAINED = 1024 * 1024;
+
+  // Builds a document and records its objects in the order they start,
+  // which is the order of their opening brackets in the source. Documents
+  // without a source get copies of the strings, see DocumentBuilder.
+  class Recorder : public qmlon::DocumentBuilder
+  {
+  public:
+    Recorder(qmlon::Document& document, std::vector<qmlon::Object*>& objects) :
+      DocumentBuilder(document), objects(objects)
+    {
+    }
+
+    void onObjectStart(qmlon::Atom type)
+    {
+      DocumentBuilder::onObjectStart(type);
+      objects.push_back(current());
+    }
+
+  private:
+    std::vector<qmlon::Object*>& objects;
+  };
+
+  class Differ
+  {
+  public:
+    Differ(std::vector<qmlon::Change>& changes) : changes(changes), hasher() {}
+
+    void value(qmlon::Value const& before, qmlon::Value const& after)
+    {
+      qmlon::Object const* a = before.tryAsObject();
+      qmlon::Object const* b = after.tryAsObject();
+      if(a && b && a->type == b->type)
+      {
+        object(*a, *b, "");
+      }
+      else if(hasher.hash(before) != hasher.hash(after))
+      {
+        add(qmlon::Change::CHANGED, "", a, b, qmlon::Atom());
+      }
+    }
+
+  private:
+    // Objects that are not the same object are compared member by member,
+    // which costs about as much as hashing them
+    void object(qmlon::Object const& before, qmlon::Object const& after, std::string const& path)
+    {
+      if(&before == &after)
+      {
+        return;
+      }
+
+      for(auto const& property : before.properties)
+      {
+        if(!after.hasProperty(property.first))
+        {
+          add(qmlon::Change::REMOVED, join(path, property.first.name()), &before, &after, property.first);
+        }
+      }
+
+      for(auto const& property : after.properties)
+      {
+        auto previous = before.properties.find(property.first);
+        if(previous == before.properties.end())
+        {
+          add(qmlon::Change::ADDED, join(path, property.first.name()), &before, &after, property.first);
+          continue;
+        }
+
+        qmlon::Object const* a = previous->second.tryAsObject();
+        qmlon::Object const* b = property.second.tryAsObject();
+        if(a && b && a->type == b->type)
+        {
+          object(*a, *b, join(path, property.first.name()));
+        }
+        else if(hasher.hash(previous->second) != hasher.hash(property.second))
+        {
+          add(qmlon::Change::CHANGED, join(path, property.first.name()), &before, &after, property.first);
+        }
+      }
+
+      children(before, after, path);
+    }
+
+    // Children that are the same at the start and the end are skipped. Only
+    // if children were inserted or removed are the ones that are not the same
+    // object compared by hash.
+    void children(qmlon::Object const& before, qmlon::Object const& after, std::string const& path)
+    {
+      std::size_t n = before.children.size();
+      std::size_t m = after.children.size();
+      std::size_t first = 0;
+      std::size_t last = 0;
+      for(bool hashed : {false, true})
+      {
+        if(hashed && n == m)
+        {
+          break;
+        }
+
+        while(first < n - last && first < m - last && same(before.children[first], after.children[first], hashed))
+        {
+          ++first;
+        }
+        while(last < n - first && last < m - first && same(before.children[n - 1 - last], after.children[m - 1 - last], hashed))
+        {
+          ++last;
+        }
+      }
+
+      // Children of the same type are paired. Otherwise the side with more
+      // children left is taken to have had one inserted or removed.
+      std::size_t i = first;
+      std::size_t j = first;
+      while(i < n - last || j < m - last)
+      {
+        qmlon::Object const* a = i < n - last ? before.children[i] : nullptr;
+        qmlon::Object const* b = j < m - last ? after.children[j] : nullptr;
+        if(a && b && a->type == b->type)
+        {
+          object(*a, *b, child(path, b, j));
+          ++i;
+          ++j;
+        }
+        else if(b && n - last - i < m - last - j)
+        {
+          add(qmlon::Change::ADDED, child(path, b, j++), nullptr, b, qmlon::Atom());
+        }
+        else if(a && n - last - i > m - last - j)
+        {
+          add(qmlon::Change::REMOVED, child(path, a, i++), a, nullptr, qmlon::Atom());
+        }
+        else
+        {
+          add(qmlon::Change::REMOVED, child(path, a, i++), a, nullptr, qmlon::Atom());
+          add(qmlon::Change::ADDED, child(path, b, j++), nullptr, b, qmlon::Atom());
+        }
+      }
+    }
+
+    bool same(qmlon::Object const* a, qmlon::Object const* b, bool hashed)
+    {
+      return a == b || (hashed && a->type == b->type && hasher.hash(*a) == hasher.hash(*b));
+    }
+
+    void add(qmlon::Change::Kind kind, std::string const& path, qmlon::Object const* before, qmlon::Object const* after, qmlon::Atom property)
+    {
+      changes.push_back(qmlon::Change{kind, path, before, after, property});
+    }
+
+    static std::string join(std::string const& path, qmlon::StringRef name)
+    {
+      return path.empty() ? name.str() : path + "/" + name.str();
+    }
+
+    static std::string child(std::string const& path, qmlon::Object const* object, std::size_t index)
+    {
+      return join(path, object->type.name()) + "[" + std::to_string(index) + "]";
+    }
+
+    std::vector<qmlon::Change>& changes;
+    qmlon::StructuralHasher hasher;
+  };
+}
+
+std::vector<qmlon::Change> qmlon::diff(Value const& before, Value const& after)
+{
+  std::vector<Change> changes;
+  Differ(changes).value(before, after);
+  return changes;
+}
+
+qmlon::Reloader::Reloader(Source::Reference const& source) :
+  text(), document(), nodes(), retained(0), parsed(0)
+{
+  read(source);
+}
+
+std::vector<qmlon::Change> qmlon::Reloader::reload(Source::Reference const& source)
+{
+  Value::Reference before = getRoot();
+  if(!update(source))
+  {
+    read(source);
+  }
+  return diff(*before, *getRoot());
+}
+
+void qmlon::Reloader::read(Source::Reference const& source)
+{
+  if(source->length() > UINT32_MAX)
+  {
+    throw std::length_error("Reloaded QMLON documents are limited to 4 GiB");
+  }
+
+  Document::Reference next = Document::create(source);
+  std::vector<Object*> objects;
+  Recorder recorder(*next, objects);
+  Parser parser(source->data(), source->length(), recorder);
+  parser.readValue();
+
+  // Objects start in the order of their opening brackets
+  StructuralIndex index(source->data(), source->length());
+  std::vector<Node> read;
+  std::vector<std::uint32_t> open;
+  for(StructuralIndex::Span const& span : index.getSpans())
+  {
+    if(source->data()[span.open] != '{')
+    {
+      continue;
+    }
+    else if(read.size() == objects.size())
+    {
+      // Objects after the root value are not part of the document
+      break;
+    }
+
+    while(!open.empty() && read[open.back()].close < span.open)
+    {
+      read[open.back()].end = read.size();
+      open.pop_back();
+    }
+
+    read.push_back(Node{objects[read.size()], span.open, span.close, 0, open.empty() ? NONE : open.back()});
+    open.push_back(read.size() - 1);
+  }
+
+  for(std::uint32_t i : open)
+  {
+    read[i].end = read.size();
+  }
+
+  text = source;
+  document = next;
+  nodes.swap(read);
+  retained = 0;
+  parsed = source->length();
+}
+
+bool qmlon::Reloader::update(Source::Reference const& source)
+{
+  char const* a = text->data();
+  char const* b = source->data();
+  std::size_t n = text->length();
+  std::size_t m = source->length();
+  if(m > UINT32_MAX || nodes.empty() || !document->getRoot()->isObject())
+  {
+    return false;
+  }
+
+  // The edit replaced [first, n - last) of the old text with [first, m - last)
+  std::size_t first = 0;
+  while(first < n && first < m && a[first] == b[first])
+  {
+    ++first;
+  }
+
+  std::size_t last = 0;
+  while(last < n - first && last < m - first && a[n - 1 - last] == b[m - 1 - last])
+  {
+    ++last;
+  }
+
+  if(first == n && n == m)
+  {
+    parsed = 0;
+    return true;
+  }
+
+  // Innermost object whose brackets enclose the edit
+  std::uint32_t target = NONE;
+  for(std::uint32_t i = 0; i < nodes.size();)
+  {
+    Node const& node = nodes[i];
+    if(node.open < first && node.close >= n - last)
+    {
+      target = i++;
+    }
+    else if(node.close < first)
+    {
+      i = node.end;
+    }
+    else
+    {
+      break;
+    }
+
+    if(target != NONE && i == nodes[target].end)
+    {
+      break;
+    }
+  }
+
+  if(target == NONE)
+  {
+    return false;
+  }
+
+  // The object is parsed with its brackets, so that an edit that moves its
+  // end, for example by opening a comment, is found
+  Node const& old = nodes[target];
+  std::ptrdiff_t delta = std::ptrdiff_t(m) - std::ptrdiff_t(n);
+  std::size_t open = old.open;
+  std::size_t close = old.close + delta;
+
+  Document::Reference part = Document::create();
+  std::vector<Object*> objects;
+  std::vector<Node> added;
+  try
+  {
+    Recorder recorder(*part, objects);
+    Parser parser(b + open, close + 1 - open, recorder);
+    parser.readValue();
+    parser.readEnd();
+
+    StructuralIndex index(b + open, close + 1 - open);
+    std::vector<std::uint32_t> stack;
+    for(StructuralIndex::Span const& span : index.getSpans())
+    {
+      if(b[open + span.open] != '{')
+      {
+        continue;
+      }
+
+      while(!stack.empty() && added[stack.back()].close < open + span.open)
+      {
+        added[stack.back()].end = target + added.size();
+        stack.pop_back();
+      }
+
+      std::uint32_t parent = stack.empty() ? old.parent : target + stack.back();
+      added.push_back(Node{objects[added.size()], std::uint32_t(open + span.open), std::uint32_t(open + span.close), 0, parent});
+      stack.push_back(added.size() - 1);
+    }
+
+    for(std::uint32_t i : stack)
+    {
+      added[i].end = target + added.size();
+    }
+  }
+  catch(std::runtime_error const&)
+  {
+    // Errors are reported by a full read, with their usual positions
+    return false;
+  }
+
+  Object* replacement = objects.front();
+  replacement->type = old.object->type;
+
+  // Objects enclosing the edited one are copied with the new version in
+  // place of the old. The new document refers to the previous one for
+  // everything else.
+  Document::Reference next = Document::create();
+  next->addPart(document);
+  next->addPart(part);
+
+  Object const* from = old.object;
+  Object* to = replacement;
+  for(std::uint32_t i = old.parent; i != NONE; i = nodes[i].parent)
+  {
+    Object* copy = replace(*nodes[i].object, from, to, next->getArena());
+    from = nodes[i].object;
+    to = copy;
+    nodes[i].object = copy;
+    nodes[i].close += delta;
+  }
+  next->setRoot(Value::createObject(to));
+
+  // Nodes of the edited object are replaced by the new ones, and the
+  // positions of the following nodes move with the edit
+  std::ptrdiff_t shift = std::ptrdiff_t(added.size()) - std::ptrdiff_t(old.end - target);
+  std::uint32_t oldEnd = old.end;
+  for(Node& node : nodes)
+  {
+    if(node.end >= oldEnd && &node < &nodes[target])
+    {
+      node.end += shift;
+    }
+  }
+
+  nodes.erase(nodes.begin() + target, nodes.begin() + oldEnd);
+  nodes.insert(nodes.begin() + target, added.begin(), added.end());
+  for(std::size_t i = target + added.size(); i < nodes.size(); ++i)
+  {
+    Node& node = nodes[i];
+    node.open += delta;
+    node.close += delta;
+    node.end += shift;
+    if(node.parent != NONE && node.parent >= oldEnd)
+    {
+      node.parent += shift;
+    }
+  }
+
+  retained += part->getArena().capacity() + next->getArena().capacity();
+  text = source;
+  document = next;
+  parsed = close + 1 - open;
+
+  // Old versions are released when they hold more memory than the text needs
+  return retained <= std::max(m, MIN_RETAINED);
+}
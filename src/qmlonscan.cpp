@@ -0,0 +1,271 @@
+#include "qmlonscan.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define QMLON_SCAN_X86
+#include <immintrin.h>
+#endif
+
+namespace
+{
+  bool isWhitespace(char c)
+  {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+  }
+
+  char const* scalarSkipWhitespace(char const* p, char const* end)
+  {
+    while(p != end && isWhitespace(*p))
+      ++p;
+    return p;
+  }
+
+  char const* scalarFindLineBreak(char const* p, char const* end)
+  {
+    while(p != end && *p != '\n' && *p != '\r')
+      ++p;
+    return p;
+  }
+
+  char const* scalarFindBlockCommentEnd(char const* p, char const* end)
+  {
+    while(p != end && !(*p == '*' && p + 1 != end && p[1] == '/'))
+      ++p;
+    return p;
+  }
+
+  char const* scalarFindQuoteOrBackslash(char const* p, char const* end)
+  {
+    while(p != end && *p != '"' && *p != '\\')
+      ++p;
+    return p;
+  }
+
+#ifdef QMLON_SCAN_X86
+  // Each vectorized kernel handles full 16 or 32 byte blocks and leaves the
+  // tail to the scalar implementation. Matches are collected into a bit mask
+  // with one bit per byte, so the first match is the lowest set bit.
+
+  __attribute__((target("sse2")))
+  char const* sse2SkipWhitespace(char const* p, char const* end)
+  {
+    __m128i const space = _mm_set1_epi8(' ');
+    __m128i const tab = _mm_set1_epi8('\t');
+    __m128i const cr = _mm_set1_epi8('\r');
+    __m128i const lf = _mm_set1_epi8('\n');
+
+    for(; end - p >= 16; p += 16)
+    {
+      __m128i block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+      __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, space), _mm_cmpeq_epi8(block, tab)),
+                                _mm_or_si128(_mm_cmpeq_epi8(block, cr), _mm_cmpeq_epi8(block, lf)));
+      unsigned int mask = ~_mm_movemask_epi8(ws) & 0xffffu;
+      if(mask)
+        return p + __builtin_ctz(mask);
+    }
+
+    return scalarSkipWhitespace(p, end);
+  }
+
+  __attribute__((target("sse2")))
+  char const* sse2FindLineBreak(char const* p, char const* end)
+  {
+    __m128i const cr = _mm_set1_epi8('\r');
+    __m128i const lf = _mm_set1_epi8('\n');
+
+    for(; end - p >= 16; p += 16)
+    {
+      __m128i block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+      unsigned int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, cr), _mm_cmpeq_epi8(block, lf)));
+      if(mask)
+        return p + __builtin_ctz(mask);
+    }
+
+    return scalarFindLineBreak(p, end);
+  }
+
+  __attribute__((target("sse2")))
+  char const* sse2FindBlockCommentEnd(char const* p, char const* end)
+  {
+    __m128i const asterisk = _mm_set1_epi8('*');
+    __m128i const slash = _mm_set1_epi8('/');
+
+    // Compare each byte and the byte following it, so 17 bytes are needed
+    for(; end - p >= 17; p += 16)
+    {
+      __m128i block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+      __m128i shifted = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p + 1));
+      unsigned int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(block, asterisk), _mm_cmpeq_epi8(shifted, slash)));
+      if(mask)
+        return p + __builtin_ctz(mask);
+    }
+
+    return scalarFindBlockCommentEnd(p, end);
+  }
+
+  __attribute__((target("sse2")))
+  char const* sse2FindQuoteOrBackslash(char const* p, char const* end)
+  {
+    __m128i const quote = _mm_set1_epi8('"');
+    __m128i const backslash = _mm_set1_epi8('\\');
+
+    for(; end - p >= 16; p += 16)
+    {
+      __m128i block = _mm_loadu_si128(reinterpret_cast<__m128i const*>(p));
+      unsigned int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(block, quote), _mm_cmpeq_epi8(block, backslash)));
+      if(mask)
+        return p + __builtin_ctz(mask);
+    }
+
+    return scalarFindQuoteOrBackslash(p, end);
+  }
+
+  __attribute__((target("avx2")))
+  char const* avx2SkipWhitespace(char const* p, char const* end)
+  {
+    __m256i const space = _mm256_set1_epi8(' ');
+    __m256i const tab = _mm256_set1_epi8('\t');
+    __m256i const cr = _mm256_set1_epi8('\r');
+    __m256i const lf = _mm256_set1_epi8('\n');
+
+    for(; end - p >= 32; p += 32)
+    {
+      __m256i block = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p));
+      __m256i ws = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, space), _mm256_cmpeq_epi8(block, tab)),
+                                   _mm256_or_si256(_mm256_cmpeq_epi8(block, cr), _mm256_cmpeq_epi8(block, lf)));
+      unsigned int mask = ~static_cast<unsigned int>(_mm256_movemask_epi8(ws));
+      if(mask)
+        return p + __builtin_ctz(mask);
+    }
+
+    return sse2SkipWhitespace(p, end);
+  }
+
+  __attribute__((target("avx2")))
+  char const* avx2FindLineBreak(char const* p, char const* end)
+  {
+    __m256i const cr = _mm256_set1_epi8('\r');
+    __m256i const lf = _mm256_set1_epi8('\n');
+
+    for(; end - p >= 32; p += 32)
+    {
+      __m256i block = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p));
+      unsigned int mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(block, cr), _mm256_cmpeq_epi8(block, lf)));
+      if(mask)
+        return p + __builtin_ctz(mask);
+    }
+
+    return sse2FindLineBreak(p, end);
+  }
+
+  __attribute__((target("avx2")))
+  char const* avx2FindBlockCommentEnd(char const* p, char const* end)
+  {
+    __m256i const asterisk = _mm256_set1_epi8('*');
+    __m256i const slash = _mm256_set1_epi8('/');
+
+    for(; end - p >= 33; p += 32)
+    {
+      __m256i block = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p));
+      __m256i shifted = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p + 1));
+      unsigned int mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(block, asterisk), _mm256_cmpeq_epi8(shifted, slash)));
+      if(mask)
+        return p + __builtin_ctz(mask);
+    }
+
+    return sse2FindBlockCommentEnd(p, end);
+  }
+
+  __attribute__((target("avx2")))
+  char const* avx2FindQuoteOrBackslash(char const* p, char const* end)
+  {
+    __m256i const quote = _mm256_set1_epi8('"');
+    __m256i const backslash = _mm256_set1_epi8('\\');
+
+    for(; end - p >= 32; p += 32)
+    {
+      __m256i block = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(p));
+      unsigned int mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(block, quote), _mm256_cmpeq_epi8(block, backslash)));
+      if(mask)
+        return p + __builtin_ctz(mask);
+    }
+
+    return sse2FindQuoteOrBackslash(p, end);
+  }
+#endif
+}
+
+qmlon::scan::Kernels const* qmlon::scan::scalarKernels()
+{
+  static Kernels const k = {"scalar", scalarSkipWhitespace, scalarFindLineBreak, scalarFindBlockCommentEnd, scalarFindQuoteOrBackslash};
+  return &k;
+}
+
+qmlon::scan::Kernels const* qmlon::scan::sse2Kernels()
+{
+#ifdef QMLON_SCAN_X86
+  __builtin_cpu_init();
+  static Kernels const k = {"sse2", sse2SkipWhitespace, sse2FindLineBreak, sse2FindBlockCommentEnd, sse2FindQuoteOrBackslash};
+  return __builtin_cpu_supports("sse2") ? &k : nullptr;
+#else
+  return nullptr;
+#endif
+}
+
+qmlon::scan::Kernels const* qmlon::scan::avx2Kernels()
+{
+#ifdef QMLON_SCAN_X86
+  __builtin_cpu_init();
+  static Kernels const k = {"avx2", avx2SkipWhitespace, avx2FindLineBreak, avx2FindBlockCommentEnd, avx2FindQuoteOrBackslash};
+  return __builtin_cpu_supports("avx2") ? &k : nullptr;
+#else
+  return nullptr;
+#endif
+}
+
+qmlon::scan::Kernels const& qmlon::scan::kernels()
+{
+  static Kernels const* const selected = avx2Kernels() ? avx2Kernels() : sse2Kernels() ? sse2Kernels() : scalarKernels();
+  return *selected;
+}
+
+char const* qmlon::scan::findBracket(char const* p, char const* end)
+{
+  for(; p != end; ++p)
+  {
+    switch(*p)
+    {
+      case '"':
+        p = findQuoteOrBackslash(p + 1, end);
+        while(p != end && *p == '\\')
+        {
+          p = end - p > 2 ? findQuoteOrBackslash(p + 2, end) : end;
+        }
+        break;
+
+      case '/':
+        if(end - p > 1 && p[1] == '/')
+        {
+          p = findLineBreak(p + 2, end);
+        }
+        else if(end - p > 1 && p[1] == '*')
+        {
+          char const* asterisk = findBlockCommentEnd(p + 2, end);
+          p = asterisk == end ? end : asterisk + 1;
+        }
+        break;
+
+      case '{':
+      case '[':
+      case '}':
+      case ']':
+        return p;
+    }
+
+    if(p == end)
+    {
+      break;
+    }
+  }
+
+  return end;
+}
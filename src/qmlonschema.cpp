@@ -29,8 +29,8 @@ qmlon::Schema& qmlon::Schema::initialize(Schema& schema, qmlon::Value::Reference
     {"max", qmlon::set(&ListValue::setMax)}
   });
 
-  std::function<qmlon::Schema::Value::Reference(qmlon::Value::Reference)> createValue([&](qmlon::Value::Reference value) {
-    qmlon::Object& o = value->asObject();
+  std::function<qmlon::Schema::Value::Reference(qmlon::Value const&)> createValue([&](qmlon::Value const& value) {
+    qmlon::Object& o = value.asObject();
     qmlon::Schema::Value::Reference result;
 
     if(o.type == "Boolean")
@@ -78,17 +78,16 @@ qmlon::Schema& qmlon::Schema::initialize(Schema& schema, qmlon::Value::Reference
   });
 
   lvi.addPropertySetter("type", [&](ListValue& x, qmlon::Value::Reference v) {
-    if(v->isList())
+    if(qmlon::Value::List const* l = v->tryAsList())
     {
-      qmlon::Value::List l = v->asList();
-      for(qmlon::Value::Reference vr : l)
+      for(qmlon::Value const& vr : *l)
       {
         x.addValidType(createValue(vr));
       }
     }
     else if(v->isObject())
     {
-      x.addValidType(createValue(v));
+      x.addValidType(createValue(*v));
     }
   });
 
@@ -97,17 +96,16 @@ qmlon::Schema& qmlon::Schema::initialize(Schema& schema, qmlon::Value::Reference
     {"optional", qmlon::set(&Property::setOptional)},
     {"type", [&](Property& x, qmlon::Value::Reference v) {
 
-      if(v->isList())
+      if(qmlon::Value::List const* l = v->tryAsList())
       {
-        qmlon::Value::List l = v->asList();
-        for(qmlon::Value::Reference vr : l)
+        for(qmlon::Value const& vr : *l)
         {
           x.addValidType(createValue(vr));
         }
       }
       else if(v->isObject())
       {
-        x.addValidType(createValue(v));
+        x.addValidType(createValue(*v));
       }
       else
       {
@@ -139,7 +137,7 @@ qmlon::Schema& qmlon::Schema::initialize(Schema& schema, qmlon::Value::Reference
     {"", [&](Schema& x, qmlon::Object& obj) {
       Object o;
       oi.init(o, obj);
-      o.setType(obj.type);
+      o.setType(obj.type.str());
       x.addObject(o);
     }}
   });
@@ -165,18 +163,18 @@ qmlon::Schema::Schema(qmlon::Value::Reference value) :
   initialize(*this, value);
 }
 
-bool qmlon::Schema::Child::validate(qmlon::Object::Reference object) const
+bool qmlon::Schema::Child::validate(qmlon::Object const& object) const
 {
   auto objectType = schema->getObjects().find(type);
   if(objectType == schema->getObjects().end())
     return false;
 
-  if(!objectType->second.getIsInterface() && object->type != type)
+  if(!objectType->second.getIsInterface() && object.type != type)
   {
     return false;
   }
 
-  if(!objectType->second.validate(*object))
+  if(!objectType->second.validate(object))
   {
     return false;
   }
@@ -219,18 +217,18 @@ bool qmlon::Schema::Object::validate(qmlon::Object const& value) const
       return false;
   }
 
-  std::map<std::string, int> n;
+  std::map<Atom, int> n;
   for(Child const& child : children)
   {
     n[child.getType()] = 0;
   }
 
-  for(qmlon::Object::Reference object : value.children)
+  for(qmlon::Object const* object : value.children)
   {
     bool valid = false;
     for(Child const& child : children)
     {
-      if(child.validate(object))
+      if(child.validate(*object))
       {
         valid = true;
         n[child.getType()] += 1;
@@ -255,49 +253,48 @@ bool qmlon::Schema::Object::validate(qmlon::Object const& value) const
   return true;
 }
 
-bool qmlon::Schema::BooleanValue::validate(qmlon::Value::Reference const& value) const
+bool qmlon::Schema::BooleanValue::validate(qmlon::Value const& value) const
 {
-  return value->isBoolean();
+  return value.isBoolean();
 }
 
-bool qmlon::Schema::IntegerValue::validate(qmlon::Value::Reference const& value) const
+bool qmlon::Schema::IntegerValue::validate(qmlon::Value const& value) const
 {
-  if(!value->isInteger())
+  std::int64_t i;
+  if(!value.tryAsInt64(i))
     return false;
 
-  int i = value->asInteger();
   return (!min.set || i >= min.value) && (!max.set || i <= max.value);
 }
 
-bool qmlon::Schema::FloatValue::validate(qmlon::Value::Reference const& value) const
+bool qmlon::Schema::FloatValue::validate(qmlon::Value const& value) const
 {
-  if(!value->isFloat())
+  double f;
+  if(!value.tryAsDouble(f))
     return false;
 
-  float f = value->asFloat();
   return (!min.set || f >= min.value) && (!max.set || f <= max.value);
 }
 
-bool qmlon::Schema::StringValue::validate(qmlon::Value::Reference const& value) const
+bool qmlon::Schema::StringValue::validate(qmlon::Value const& value) const
 {
-  if(!value->isString())
+  qmlon::StringRef s;
+  if(!value.tryAsStringRef(s))
     return false;
 
-  std::string s = value->asString();
   return (!min.set || s.length() >= min.value) && (!max.set || s.length() <= max.value);
 }
 
-bool qmlon::Schema::ListValue::validate(qmlon::Value::Reference const& value) const
+bool qmlon::Schema::ListValue::validate(qmlon::Value const& value) const
 {
-  if(!value->isList())
+  qmlon::Value::List const* l = value.tryAsList();
+  if(!l)
     return false;
 
-  qmlon::Value::List l = value->asList();
-
-  if((min.set && l.size() < min.value) || (max.set && l.size() > max.value))
+  if((min.set && l->size() < min.value) || (max.set && l->size() > max.value))
     return false;
 
-  for(qmlon::Value::Reference const& v : l)
+  for(qmlon::Value const& v : *l)
   {
     bool valid = false;
     for(Value::Reference type : validTypes.value)
@@ -316,9 +313,10 @@ bool qmlon::Schema::ListValue::validate(qmlon::Value::Reference const& value) co
   return true;
 }
 
-bool qmlon::Schema::ObjectValue::validate(qmlon::Value::Reference const& value) const
+bool qmlon::Schema::ObjectValue::validate(qmlon::Value const& value) const
 {
-  if(!value->isObject())
+  qmlon::Object* o = value.tryAsObject();
+  if(!o)
     return false;
 
   if(!type.set)
@@ -328,7 +326,7 @@ bool qmlon::Schema::ObjectValue::validate(qmlon::Value::Reference const& value)
   if(object == schema->getObjects().end())
     return false;
 
-  return object->second.validate(value->asObject());
+  return object->second.validate(*o);
 }
 
 bool qmlon::Schema::validate(qmlon::Value::Reference const& value) const
@@ -336,12 +334,13 @@ bool qmlon::Schema::validate(qmlon::Value::Reference const& value) const
   if(root.empty())
     return false;
 
-  if(!value->isObject())
+  qmlon::Object* o = value->tryAsObject();
+  if(!o)
     return false;
 
   auto rootObject = objects.find(root);
   if(rootObject == objects.end())
     return false;
 
-  return rootObject->second.validate(value->asObject());
+  return rootObject->second.validate(*o);
 }
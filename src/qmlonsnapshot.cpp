@@ -0,0 +1,287 @@
+#include "qmlonsnapshot.h"
+#include "qmlonbinary.h"
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+  // Finds the objects enclosing the target, outermost first
+  bool find(qmlon::Value const& value, qmlon::Object const* target, std::vector<qmlon::Object const*>& path)
+  {
+    if(qmlon::Object const* object = value.tryAsObject())
+    {
+      if(object == target)
+      {
+        return true;
+      }
+
+      path.push_back(object);
+      for(auto const& property : object->properties)
+      {
+        if(find(property.second, target, path))
+        {
+          return true;
+        }
+      }
+      for(auto const& child : object->children)
+      {
+        if(find(qmlon::Value::createObject(child), target, path))
+        {
+          return true;
+        }
+      }
+      path.pop_back();
+    }
+    else if(qmlon::Value::List const* list = value.tryAsList())
+    {
+      for(qmlon::Value const& item : *list)
+      {
+        if(find(item, target, path))
+        {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  // Whether the target is the value or an item of it
+  bool holds(qmlon::Value const& value, qmlon::Object const* target)
+  {
+    if(value.tryAsObject() == target)
+    {
+      return true;
+    }
+    else if(qmlon::Value::List const* list = value.tryAsList())
+    {
+      for(qmlon::Value const& item : *list)
+      {
+        if(holds(item, target))
+        {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  // Whether the target is directly in the object
+  bool holds(qmlon::Object const& object, qmlon::Object const* target)
+  {
+    for(auto const& child : object.children)
+    {
+      if(child == target)
+      {
+        return true;
+      }
+    }
+    for(auto const& property : object.properties)
+    {
+      if(holds(property.second, target))
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  typedef std::unordered_map<qmlon::Object const*, qmlon::Object*> Copies;
+
+  // Copy of a value owned by the document. Objects reached more than once
+  // are copied once.
+  qmlon::Value copy(qmlon::Value const& value, qmlon::Document& document, Copies& copies)
+  {
+    if(value.isString())
+    {
+      return document.createString(value.asStringRef());
+    }
+    else if(qmlon::Object const* object = value.tryAsObject())
+    {
+      auto existing = copies.find(object);
+      if(existing != copies.end())
+      {
+        return qmlon::Value::createObject(existing->second);
+      }
+
+      qmlon::Object* result = document.createObject(object->type);
+      copies[object] = result;
+      for(auto const& property : object->properties)
+      {
+        result->properties.insert(std::make_pair(property.first, copy(property.second, document, copies)));
+      }
+      for(auto const& child : object->children)
+      {
+        result->children.push_back(copy(qmlon::Value::createObject(child), document, copies).tryAsObject());
+      }
+      return document.createObject(result);
+    }
+    else if(qmlon::Value::List const* list = value.tryAsList())
+    {
+      qmlon::Value::List items = document.createList();
+      for(qmlon::Value const& item : *list)
+      {
+        items.push_back(copy(item, document, copies));
+      }
+      return document.createList(std::move(items));
+    }
+    return value;
+  }
+}
+
+qmlon::Snapshot::Snapshot(Document::Reference const& document) :
+  document(document), root(document->getRoot().get())
+{
+}
+
+qmlon::Snapshot::Reference qmlon::Snapshot::create(Document::Reference const& document)
+{
+  loadAll(*document->getRoot());
+  return Reference(new Snapshot(document));
+}
+
+qmlon::Value::Reference qmlon::Snapshot::getRootReference() const
+{
+  return document->getRoot();
+}
+
+qmlon::Snapshot::Reference qmlon::Snapshot::update(Object const& object, Edit const& edit) const
+{
+  std::vector<Object const*> path;
+  if(!find(*root, &object, path))
+  {
+    throw std::invalid_argument("ERROR: Object is not part of the snapshot");
+  }
+  path.push_back(&object);
+  return update(path, edit);
+}
+
+qmlon::Snapshot::Reference qmlon::Snapshot::update(std::vector<Object const*> const& path, Edit const& edit) const
+{
+  bool valid = !path.empty() && holds(*root, path.front());
+  for(std::size_t i = 1; valid && i < path.size(); ++i)
+  {
+    valid = holds(*path[i - 1], path[i]);
+  }
+  if(!valid)
+  {
+    throw std::invalid_argument("ERROR: Path is not part of the snapshot");
+  }
+
+  Document::Reference next = Document::create();
+  next->addPart(document);
+  Arena& arena = next->getArena();
+
+  Object const& object = *path.back();
+  Object* edited = arena.create<Object>(&arena);
+  edited->type = object.type;
+  for(auto const& property : object.properties)
+  {
+    edited->properties.insert(property);
+  }
+  for(auto const& child : object.children)
+  {
+    edited->children.push_back(child);
+  }
+  edit(*edited, *next);
+
+  // The enclosing objects are copied up to the root
+  Object const* from = &object;
+  Object* to = edited;
+  for(std::size_t i = path.size() - 1; i > 0; --i)
+  {
+    to = replace(*path[i - 1], from, to, arena);
+    from = path[i - 1];
+  }
+  next->setRoot(replace(*root, from, to, arena));
+
+  return Reference(new Snapshot(next));
+}
+
+qmlon::Snapshot::Reference qmlon::Snapshot::setProperty(Object const& object, Atom name, Value const& value) const
+{
+  return update(object, [&](Object& copy, Document& document) {
+    copy.setProperty(name, value.isString() ? document.createString(value.asStringRef()) : value);
+  });
+}
+
+qmlon::Snapshot::Reference qmlon::Snapshot::removeChild(Object const& object, Object const& child) const
+{
+  return update(object, [&](Object& copy, Document&) {
+    for(auto i = copy.children.begin(); i != copy.children.end(); ++i)
+    {
+      if(*i == &child)
+      {
+        copy.children.erase(i);
+        break;
+      }
+    }
+  });
+}
+
+qmlon::Snapshot::Reference qmlon::Snapshot::compact() const
+{
+  Document::Reference next = Document::create();
+  Copies copies;
+  next->setRoot(copy(*root, *next, copies));
+  return Reference(new Snapshot(next));
+}
+
+qmlon::Snapshot::Reference qmlon::SharedSnapshot::update(std::function<Snapshot::Reference(Snapshot const&)> const& f)
+{
+  Snapshot::Reference expected = get();
+  for(;;)
+  {
+    Snapshot::Reference next = f(*expected);
+    if(std::atomic_compare_exchange_strong(&current, &expected, next))
+    {
+      return next;
+    }
+  }
+}
+
+qmlon::Value qmlon::replace(Value const& value, Object const* from, Object* to, Arena& arena)
+{
+  if(value.tryAsObject() == from)
+  {
+    return Value::createObject(to);
+  }
+  else if(Value::List const* list = value.tryAsList())
+  {
+    // The object may be in the list more than once, for example in
+    // deduplicated documents, so all of them are replaced in one copy
+    Value::List* copy = nullptr;
+    for(std::size_t i = 0; i < list->size(); ++i)
+    {
+      Value item = replace((*list)[i], from, to, arena);
+      if(item.tryAsObject() != (*list)[i].tryAsObject() || item.tryAsList() != (*list)[i].tryAsList())
+      {
+        if(!copy)
+        {
+          copy = arena.create<Value::List>(*list, &arena);
+        }
+        (*copy)[i] = item;
+      }
+    }
+    if(copy)
+    {
+      return Value::createList(copy);
+    }
+  }
+  return value;
+}
+
+qmlon::Object* qmlon::replace(Object const& object, Object const* from, Object* to, Arena& arena)
+{
+  Object* copy = arena.create<Object>(&arena);
+  copy->type = object.type;
+  for(auto const& property : object.properties)
+  {
+    copy->properties.insert(std::make_pair(property.first, replace(property.second, from, to, arena)));
+  }
+  for(auto const& child : object.children)
+  {
+    copy->children.push_back(child == from ? to : child);
+  }
+  return copy;
+}
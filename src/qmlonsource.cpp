@@ -0,0 +1,105 @@
+#include "qmlonsource.h"
+#include "qmlonlexer.h"
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define QMLON_SOURCE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+qmlon::Source::Source() :
+  buffer(), ptr(nullptr), len(0), mapped(false)
+{
+}
+
+qmlon::Source::~Source()
+{
+#ifdef QMLON_SOURCE_MMAP
+  if(mapped)
+  {
+    munmap(const_cast<char*>(ptr), len);
+  }
+#endif
+}
+
+qmlon::Source::Reference qmlon::Source::fromFile(std::string const& filename)
+{
+#ifdef QMLON_SOURCE_MMAP
+  int fd = open(filename.c_str(), O_RDONLY);
+  if(fd < 0)
+  {
+    throw std::runtime_error("ERROR: Could not open file " + filename);
+  }
+
+  struct stat info;
+  if(fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+  {
+    void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if(data != MAP_FAILED)
+    {
+      close(fd);
+      std::shared_ptr<Source> source(new Source);
+      source->ptr = static_cast<char const*>(data);
+      source->len = info.st_size;
+      source->mapped = true;
+      return source;
+    }
+  }
+
+  // Pipes can only be read once, so the open descriptor is read rather
+  // than the file opened again
+  std::string content;
+  char block[64 * 1024];
+  ssize_t n;
+  while((n = read(fd, block, sizeof(block))) != 0)
+  {
+    if(n > 0)
+    {
+      content.append(block, n);
+    }
+    else if(errno != EINTR)
+    {
+      close(fd);
+      throw std::runtime_error("ERROR: Could not read file " + filename);
+    }
+  }
+
+  close(fd);
+  return fromString(std::move(content));
+#else
+  std::ifstream stream(filename, std::ios::in | std::ios::binary);
+  if(!stream)
+  {
+    throw std::runtime_error("ERROR: Could not open file " + filename);
+  }
+
+  return fromStream(stream);
+#endif
+}
+
+qmlon::Source::Reference qmlon::Source::fromStream(std::istream& stream)
+{
+  return fromString(readAll(stream));
+}
+
+qmlon::Source::Reference qmlon::Source::fromString(std::string str)
+{
+  std::shared_ptr<Source> source(new Source);
+  source->buffer.swap(str);
+  source->ptr = source->buffer.data();
+  source->len = source->buffer.length();
+  return source;
+}
+
+qmlon::Source::Reference qmlon::Source::fromMemory(char const* data, std::size_t length)
+{
+  std::shared_ptr<Source> source(new Source);
+  source->ptr = data;
+  source->len = length;
+  return source;
+}
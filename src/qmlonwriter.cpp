@@ -0,0 +1,357 @@
+#include "qmlonwriter.h"
+#include "qmlonnumber.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+  double const POWERS_OF_TEN[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  double const MAX_EXACT_INTEGER = 9007199254740992.0;
+
+  // Writes the decimal digits of a number to the end of a buffer and returns
+  // a pointer to the first digit
+  char* formatDigits(std::uint64_t value, char* end)
+  {
+    do
+    {
+      *--end = static_cast<char>('0' + value % 10);
+      value /= 10;
+    } while(value);
+    return end;
+  }
+
+  // Places the decimal point in significant digits with the exponent of the
+  // first digit, without exponent notation, which QMLON does not have
+  std::string plainDecimal(std::string const& digits, int exponent)
+  {
+    int n = digits.length();
+    if(exponent < 0)
+    {
+      return "0." + std::string(-exponent - 1, '0') + digits;
+    }
+    else if(exponent >= n - 1)
+    {
+      return digits + std::string(exponent - n + 1, '0') + ".0";
+    }
+    else
+    {
+      return digits.substr(0, exponent + 1) + "." + digits.substr(exponent + 1);
+    }
+  }
+
+  // Significant digits and decimal exponent of a positive double rounded to
+  // the given precision, without trailing zeros
+  std::string roundedDigits(double value, int precision, int& exponent)
+  {
+    char text[64];
+    std::snprintf(text, sizeof(text), "%.*e", precision - 1, value);
+
+    std::string digits;
+    char const* p = text;
+    for(; *p && *p != 'e'; ++p)
+    {
+      if(*p >= '0' && *p <= '9')
+      {
+        digits += *p;
+      }
+    }
+
+    exponent = std::atoi(p + 1);
+    std::size_t last = digits.find_last_not_of('0');
+    digits.resize(last == std::string::npos ? 1 : last + 1);
+    return digits;
+  }
+}
+
+qmlon::Writer::Writer(std::ostream& out, Mode mode, int indent) :
+  out(out), mode(mode), indent(indent), buffer()
+{
+  buffer.reserve(BUFFER_SIZE + BUFFER_SIZE / 4);
+}
+
+qmlon::Writer::~Writer()
+{
+  flush();
+}
+
+void qmlon::Writer::flush()
+{
+  out.write(buffer.data(), buffer.size());
+  buffer.clear();
+}
+
+void qmlon::Writer::write(Value const& value)
+{
+  writeValue(value, 0);
+  flush();
+}
+
+void qmlon::Writer::newline(int level)
+{
+  put('\n');
+  buffer.append(level * indent, ' ');
+}
+
+void qmlon::Writer::writeValue(Value const& value, int level)
+{
+  flushIfFull();
+  switch(value.getType())
+  {
+    case Value::BOOLEAN:
+      put(value.asBoolean() ? "true" : "false");
+      break;
+
+    case Value::INTEGER:
+      writeInteger(value.asInt64());
+      break;
+
+    case Value::FLOAT:
+      writeFloat(value.asDouble());
+      break;
+
+    case Value::STRING:
+      writeString(value.asStringRef());
+      break;
+
+    case Value::OBJECT:
+      writeObject(value.asObject(), level);
+      break;
+
+    case Value::LIST:
+      writeList(value.asList(), level);
+      break;
+  }
+}
+
+void qmlon::Writer::writeObject(Object const& object, int level)
+{
+  flushIfFull();
+  if(!object.type.empty())
+  {
+    put(object.type.name());
+    if(mode == PRETTY)
+    {
+      put(' ');
+    }
+  }
+
+  put('{');
+  if(object.properties.empty() && object.children.empty())
+  {
+    put('}');
+    return;
+  }
+
+  bool first = true;
+  for(auto const& property : object.properties)
+  {
+    if(mode == PRETTY)
+    {
+      newline(level + 1);
+    }
+    else if(!first)
+    {
+      put(',');
+    }
+
+    put(property.first.name());
+    put(mode == PRETTY ? ": " : ":");
+    writeValue(property.second, level + 1);
+    first = false;
+  }
+
+  for(auto const& child : object.children)
+  {
+    if(mode == PRETTY)
+    {
+      newline(level + 1);
+    }
+    else if(!first)
+    {
+      put(',');
+    }
+
+    writeObject(*child, level + 1);
+    first = false;
+  }
+
+  if(mode == PRETTY)
+  {
+    newline(level);
+  }
+  put('}');
+}
+
+void qmlon::Writer::writeList(Value::List const& list, int level)
+{
+  // Pretty lists of scalars stay on one line
+  bool multiline = false;
+  if(mode == PRETTY)
+  {
+    for(Value const& item : list)
+    {
+      multiline |= item.isObject() || item.isList();
+    }
+  }
+
+  put('[');
+  for(std::size_t i = 0; i < list.size(); ++i)
+  {
+    if(i > 0)
+    {
+      put(',');
+      if(mode == PRETTY && !multiline)
+      {
+        put(' ');
+      }
+    }
+
+    if(multiline)
+    {
+      newline(level + 1);
+    }
+
+    writeValue(list[i], level + 1);
+  }
+
+  if(multiline)
+  {
+    newline(level);
+  }
+  put(']');
+}
+
+void qmlon::Writer::writeString(StringRef value)
+{
+  static char const HEX[] = "0123456789abcdef";
+
+  put('"');
+  char const* run = value.begin();
+  for(char const* p = value.begin(); p != value.end(); ++p)
+  {
+    unsigned char c = *p;
+    if(c >= 0x20 && c != '"' && c != '\\')
+    {
+      continue;
+    }
+
+    buffer.append(run, p);
+    run = p + 1;
+
+    put('\\');
+    switch(c)
+    {
+      case '"': put('"'); break;
+      case '\\': put('\\'); break;
+      case '\n': put('n'); break;
+      case '\r': put('r'); break;
+      case '\t': put('t'); break;
+      case '\b': put('b'); break;
+      case '\f': put('f'); break;
+      default:
+        put("u00");
+        put(HEX[c >> 4]);
+        put(HEX[c & 0xf]);
+        break;
+    }
+  }
+
+  buffer.append(run, value.end());
+  put('"');
+}
+
+void qmlon::Writer::writeInteger(std::int64_t value)
+{
+  char digits[24];
+  char* end = digits + sizeof(digits);
+  char* first = formatDigits(value < 0 ? 0 - static_cast<std::uint64_t>(value) : value, end);
+  if(value < 0)
+  {
+    *--first = '-';
+  }
+  buffer.append(first, end);
+}
+
+void qmlon::Writer::writeFloat(double value)
+{
+  if(!std::isfinite(value))
+  {
+    throw std::domain_error("QMLON can not represent non-finite floats");
+  }
+
+  if(std::signbit(value))
+  {
+    put('-');
+    value = -value;
+  }
+
+  // Most floats in documents have few decimals. With the fewest decimals k
+  // for which round(value * 10^k) / 10^k is the value, the digits are the
+  // shortest ones, and reading them divides the same exact numbers.
+  for(int k = 0; k <= 22; ++k)
+  {
+    double scaled = value * POWERS_OF_TEN[k];
+    if(scaled > MAX_EXACT_INTEGER)
+    {
+      break;
+    }
+
+    double rounded = std::floor(scaled + 0.5);
+    if(rounded / POWERS_OF_TEN[k] == value)
+    {
+      char digits[32];
+      char* end = digits + sizeof(digits);
+      char* first = formatDigits(static_cast<std::uint64_t>(rounded), end);
+      while(end - first <= k)
+      {
+        *--first = '0';
+      }
+
+      buffer.append(first, end - k);
+      put('.');
+      if(k == 0)
+      {
+        put('0');
+      }
+      buffer.append(end - k, end);
+      return;
+    }
+  }
+
+  // Otherwise use the shortest correctly rounded precision that reads back
+  std::string text;
+  for(int precision = 15; precision <= 17; ++precision)
+  {
+    int exponent;
+    std::string digits = roundedDigits(value, precision, exponent);
+    text = plainDecimal(digits, exponent);
+
+    double back;
+    fromChars(text.data(), text.data() + text.length(), back);
+    if(back == value)
+    {
+      break;
+    }
+  }
+
+  put(text);
+}
+
+void qmlon::writeText(Value const& value, std::ostream& out, Writer::Mode mode)
+{
+  Writer(out, mode).write(value);
+}
+
+std::string qmlon::writeText(Value const& value, Writer::Mode mode)
+{
+  std::ostringstream ss;
+  writeText(value, ss, mode);
+  return ss.str();
+}
@@ -0,0 +1,72 @@
+#include "qmlon.h"
+#include "check.h"
+#include <atomic>
+#include <iostream>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+  qmlon::Value::Reference root = qmlon::readValue("Foo { bar: 1, Foo { bar: 2 } }");
+  qmlon::Object& foo = root->asObject();
+  qmlon::Object& child = *foo.children.front();
+
+  std::string name = "Foo";
+  qmlon::Atom fooAtom(name);
+  qmlon::Atom barAtom("bar");
+  qmlon::Atom found;
+
+  bool ok = true;
+  ok &= check("same name same atom", fooAtom == qmlon::Atom("Foo") && fooAtom.id() == qmlon::Atom(name).id());
+  ok &= check("different names", fooAtom != barAtom && fooAtom.id() != barAtom.id());
+  ok &= check("name", fooAtom.name() == "Foo" && fooAtom.str() == "Foo");
+  ok &= check("empty", qmlon::Atom().empty() && qmlon::Atom("").empty() && !fooAtom.empty());
+  ok &= check("parsed types interned", foo.type == fooAtom && child.type == foo.type);
+  ok &= check("compare with string", foo.type == "Foo" && foo.type != "Bar");
+  ok &= check("lookup by atom", foo.hasProperty(barAtom) && foo.getProperty(barAtom)->asInteger() == 1);
+  ok &= check("lookup by string", child.hasProperty("bar") && child.getProperty("bar")->asInteger() == 2);
+  ok &= check("find interned", qmlon::Atom::find("bar", found) && found == barAtom);
+  ok &= check("find does not intern", !qmlon::Atom::find("neverInternedName", found) && !foo.hasProperty("neverInternedName"));
+
+  // Threads interning and finding names while the table grows agree on
+  // every atom
+  int const names = 20000;
+  std::vector<std::vector<qmlon::Atom>> atoms(4, std::vector<qmlon::Atom>(names));
+  std::vector<std::thread> threads;
+  std::atomic<bool> consistent(true);
+  for(std::size_t t = 0; t < atoms.size(); ++t)
+  {
+    threads.emplace_back([&, t]() {
+      for(int i = 0; i < names; ++i)
+      {
+        int n = (i * 7 + t * 13) % names;
+        std::string name = "concurrent" + std::to_string(n);
+        qmlon::Atom atom(name);
+        qmlon::Atom again;
+        if(!qmlon::Atom::find(name, again) || again != atom || atom.name() != qmlon::StringRef(name))
+        {
+          consistent = false;
+        }
+        atoms[t][n] = atom;
+      }
+    });
+  }
+  for(std::thread& thread : threads)
+  {
+    thread.join();
+  }
+
+  bool agree = consistent;
+  for(int n = 0; n < names; ++n)
+  {
+    qmlon::Atom atom("concurrent" + std::to_string(n));
+    for(std::size_t t = 0; t < atoms.size(); ++t)
+    {
+      agree &= atoms[t][n] == atom;
+    }
+  }
+  ok &= check("concurrent interning", agree);
+
+  return report(ok, "Atoms behave correctly");
+}
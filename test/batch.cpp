@@ -0,0 +1,86 @@
+#include "qmlon.h"
+#include "qmlonbatch.h"
+#include "qmlonbinary.h"
+#include "check.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+void write(std::string const& filename, std::string const& content)
+{
+  std::ofstream out(filename, std::ios::out | std::ios::binary);
+  out << content;
+}
+
+std::string sheet(int i)
+{
+  return "Sheet { image: \"sheet" + std::to_string(i) + ".png\", Sprite { id: \"sprite\", Animation { id: \"walk\", fps: "
+    + std::to_string(i) + " } } }";
+}
+
+int main(int argc, char** argv)
+{
+  bool ok = true;
+
+  std::vector<std::string> filenames;
+  for(int i = 0; i < 500; ++i)
+  {
+    filenames.push_back("test_batch_" + std::to_string(i) + ".qmlon");
+    write(filenames.back(), sheet(i));
+  }
+  write("test_batch_binary.qmlonb", qmlon::writeBinary(*qmlon::readValue(sheet(500))));
+  write("test_batch_syntax.qmlon", "Sheet { image: ");
+  write("test_batch_invalid.qmlon", "Sheet { image: 3 }");
+  filenames.insert(filenames.begin() + 100, "test_batch_binary.qmlonb");
+  filenames.insert(filenames.begin() + 200, "test_batch_syntax.qmlon");
+  filenames.insert(filenames.begin() + 300, "test_batch_invalid.qmlon");
+  filenames.insert(filenames.begin() + 400, "test_batch_missing.qmlon");
+
+  std::ifstream f("spritesheet-schema.qmlon");
+  qmlon::Schema schema(qmlon::readValue(f));
+
+  std::atomic<int> called(0);
+  std::atomic<long> fps(0);
+  qmlon::BatchLoader loader(4, 2);
+  loader.setSchema(&schema);
+  loader.setCallback([&](std::string const& filename, qmlon::Value::Reference const& root) {
+    ++called;
+    fps += root->asObject().children[0]->children[0]->getProperty("fps")->asInteger();
+    if(filename == "test_batch_7.qmlon")
+    {
+      throw std::runtime_error("ERROR: Callback failed");
+    }
+  });
+  std::vector<qmlon::LoadResult> results = loader.load(filenames);
+
+  int failed = 0;
+  bool ordered = results.size() == filenames.size();
+  for(std::size_t i = 0; ordered && i < results.size(); ++i)
+  {
+    ordered = results[i].filename == filenames[i] && results[i].ok() == bool(results[i].root);
+    failed += !results[i].ok();
+  }
+  ok &= check("results in order", ordered);
+  ok &= check("every file went through the pipeline", called == 501 && fps == 500 * 501 / 2 && failed == 4);
+  ok &= check("binary", results[100].ok() && results[100].root->str() == qmlon::readValue(sheet(500))->str());
+  ok &= check("syntax error", !results[200].ok() && !results[200].message.empty());
+  ok &= check("invalid", !results[300].ok() && results[300].message.find("schema") != std::string::npos);
+  ok &= check("missing", !results[400].ok() && results[400].message.find("Could not open") != std::string::npos);
+  ok &= check("callback error", !results[7].ok() && results[7].message == "ERROR: Callback failed");
+  ok &= check("document", results[499].ok() && results[499].root->asObject().getProperty("image")->asString() == "sheet495.png");
+
+  qmlon::BatchLoader serial(1);
+  std::vector<qmlon::LoadResult> again = serial.load(filenames);
+  ok &= check("one thread", again.size() == results.size() && again[499].root->str() == results[499].root->str()
+    && again[7].ok() && again[300].ok());
+  ok &= check("empty batch", loader.load(std::vector<std::string>()).empty());
+
+  for(std::string const& filename : filenames)
+  {
+    std::remove(filename.c_str());
+  }
+
+  return report(ok, "Batch loaded files match single reads");
+}
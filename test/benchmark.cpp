@@ -0,0 +1,194 @@
+#include "qmlon.h"
+#include "qmlonbinary.h"
+#include "qmlonwriter.h"
+#include "qmlonreload.h"
+#include "qmlonquery.h"
+#include "qmlonbatch.h"
+#include "qmlonsnapshot.h"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <functional>
+#include <thread>
+#include <cstdio>
+#include <cstdlib>
+
+// Generates a sprite sheet like document with the given number of sprites
+std::string generateDocument(int sprites)
+{
+  std::ostringstream ss;
+  ss << "Sheet {\n  image: \"sheet.png\"\n";
+  for(int i = 0; i < sprites; ++i)
+  {
+    ss << "  Sprite {\n    id: \"sprite" << i << "\"\n";
+    for(int j = 0; j < 4; ++j)
+    {
+      ss << "    // Animation " << j << "\n";
+      ss << "    Animation {\n      id: \"animation" << j << "\"\n      fps: " << 10 + j << "\n";
+      for(int k = 0; k < 4; ++k)
+      {
+        ss << "      Frame {\n"
+           << "        position: Vec2D {x: " << k * 32 << ", y: " << j * 32 << "}\n"
+           << "        size: Size {width: 32, height: 32}\n"
+           << "        hotspot: Vec2D {x: 16, y: 0}\n"
+           << "        scale: 1.5\n"
+           << "        tags: [\"a\", \"b\", " << k << "]\n"
+           << "      }\n";
+      }
+      ss << "    }\n";
+    }
+    ss << "  }\n";
+  }
+  ss << "}\n";
+  return ss.str();
+}
+
+// Counts the objects of a value, reaching every subtree
+std::size_t countObjects(qmlon::Value const& value)
+{
+  std::size_t count = 0;
+  if(qmlon::Object* object = value.tryAsObject())
+  {
+    count += 1;
+    for(auto const& property : object->properties)
+    {
+      count += countObjects(property.second);
+    }
+    for(auto const& child : object->children)
+    {
+      count += countObjects(qmlon::Value::createObject(child));
+    }
+  }
+  else if(qmlon::Value::List const* list = value.tryAsList())
+  {
+    for(qmlon::Value const& item : *list)
+    {
+      count += countObjects(item);
+    }
+  }
+  return count;
+}
+
+// Runs the function the given number of times per round and reports the
+// fastest round
+void measure(std::string const& name, std::size_t bytes, int iterations, std::function<void()> f)
+{
+  double best = 0;
+  for(int round = 0; round < 5; ++round)
+  {
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < iterations; ++i)
+    {
+      f();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if(round == 0 || elapsed.count() < best)
+    {
+      best = elapsed.count();
+    }
+  }
+
+  double seconds = best / iterations;
+  std::cout << name << ": " << seconds * 1000.0 << " ms, "
+            << bytes / seconds / (1024.0 * 1024.0) << " MiB/s" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+  int sprites = argc > 1 ? std::atoi(argv[1]) : 5000;
+
+  std::ifstream f("spritesheet.qmlon");
+  std::string small((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+  std::string large = generateDocument(sprites);
+
+  std::cout << "Generated document: " << large.size() / (1024.0 * 1024.0) << " MiB" << std::endl;
+
+  measure("readValue spritesheet.qmlon", small.size(), 10000, [&]() { qmlon::readValue(small); });
+  std::string embedded = qmlon::writeBinary(*qmlon::readValue(small));
+  measure("readEmbedded spritesheet.qmlon", small.size(), 10000, [&]() { qmlon::readEmbedded(embedded.data(), embedded.size()); });
+  measure("readValue generated", large.size(), 1, [&]() { qmlon::readValue(large); });
+
+  qmlon::Handler handler;
+  measure("parse generated", large.size(), 1, [&]() { qmlon::parse(large, handler); });
+
+  // The source is shared so that only indexing and reading are measured
+  qmlon::Source::Reference source = qmlon::Source::fromString(large);
+  measure("readValue generated, shared source", large.size(), 1, [&]() { qmlon::readValue(source); });
+  unsigned int cores = std::thread::hardware_concurrency();
+  for(unsigned int threads = 1; threads <= (cores > 4 ? cores : 4); threads *= 2)
+  {
+    measure("readValueParallel generated, " + std::to_string(threads) + " threads", large.size(), 1, [&]() { qmlon::readValueParallel(source, threads); });
+  }
+  measure("readValueOnDemand generated, index only", large.size(), 1, [&]() { qmlon::readValueOnDemand(source); });
+  measure("readValueOnDemand generated, one sprite", large.size(), 1, [&]() {
+    qmlon::Value::Reference root = qmlon::readValueOnDemand(source);
+    qmlon::Object& sheet = root->asObject();
+    countObjects(qmlon::Value::createObject(sheet.children[sheet.children.size() / 2]));
+  });
+  measure("readValue generated, everything", large.size(), 1, [&]() { countObjects(*qmlon::readValue(source)); });
+  measure("readValueOnDemand generated, everything", large.size(), 1, [&]() { countObjects(*qmlon::readValueOnDemand(source)); });
+  measure("readValueDeduplicated generated", large.size(), 1, [&]() { qmlon::readValueDeduplicated(source); });
+  std::cout << "Memory of generated: " << qmlon::readDocument(source)->getArena().capacity() / (1024.0 * 1024.0) << " MiB, deduplicated "
+            << qmlon::readDocumentDeduplicated(source)->getArena().capacity() / (1024.0 * 1024.0) << " MiB" << std::endl;
+
+  qmlon::Source::Reference compiled = qmlon::Source::fromString(qmlon::writeBinary(*qmlon::readValue(source)));
+  std::cout << "Compiled document: " << compiled->length() / (1024.0 * 1024.0) << " MiB" << std::endl;
+  measure("readBinary generated, root only", large.size(), 1, [&]() { qmlon::readBinary(compiled, false); });
+  measure("readBinary generated, checksum", large.size(), 1, [&]() { qmlon::readBinary(compiled); });
+  measure("readBinary generated, everything", large.size(), 1, [&]() { countObjects(*qmlon::readBinary(compiled, false)); });
+
+  // An edit in the middle of the document, reverted every other time
+  qmlon::Reloader reloader(source);
+  std::string edited = large;
+  std::size_t middle = edited.find("scale: 1.5", edited.size() / 2);
+  edited.replace(middle, 10, "scale: 2.5");
+  qmlon::Source::Reference versions[] = {qmlon::Source::fromString(edited), source};
+  int version = 0;
+  measure("Reloader generated, one edit", large.size(), 1, [&]() { reloader.reload(versions[version++ % 2]); });
+
+  // Throughput is of the written text
+  qmlon::Value::Reference document = qmlon::readValue(source);
+  std::ostringstream discard;
+  std::size_t compact = qmlon::writeText(*document, qmlon::Writer::COMPACT).size();
+  std::size_t pretty = qmlon::writeText(*document, qmlon::Writer::PRETTY).size();
+  measure("writeText generated, compact", compact, 1, [&]() { discard.str(""); qmlon::writeText(*document, discard, qmlon::Writer::COMPACT); });
+  measure("writeText generated, pretty", pretty, 1, [&]() { discard.str(""); qmlon::writeText(*document, discard, qmlon::Writer::PRETTY); });
+
+  // Throughput is of the document, queried 1000 times
+  qmlon::Query query("Sprite[id=\"sprite" + std::to_string(sprites / 2) + "\"]/Animation[id=\"animation2\"]/Frame");
+  qmlon::ChildIndex index;
+  measure("Query generated, 1000 times", large.size(), 1, [&]() { for(int i = 0; i < 1000; ++i) query.select(document->asObject()); });
+  measure("Query generated with index, 1000 times", large.size(), 1, [&]() { for(int i = 0; i < 1000; ++i) query.select(document->asObject(), &index); });
+
+  // A property of an animation in the middle of the document, set 100 times
+  qmlon::Snapshot::Reference snapshot = qmlon::Snapshot::create(qmlon::readDocument(source));
+  qmlon::Object const& animation = *snapshot->getRoot().asObject().children[sprites / 2]->children[1];
+  measure("Snapshot update generated, 100 times", large.size(), 1, [&]() {
+    for(int i = 0; i < 100; ++i) snapshot->setProperty(animation, qmlon::Atom("fps"), qmlon::Value::createInteger(i));
+  });
+  std::vector<qmlon::Object const*> path = {&snapshot->getRoot().asObject(), snapshot->getRoot().asObject().children[sprites / 2], &animation};
+  measure("Snapshot update generated with path, 100 times", large.size(), 1, [&]() {
+    for(int i = 0; i < 100; ++i) snapshot->update(path, [&](qmlon::Object& copy, qmlon::Document&) { copy.setProperty(qmlon::Atom("fps"), qmlon::Value::createInteger(i)); });
+  });
+
+  // Many small files, as read at startup
+  std::vector<std::string> filenames;
+  for(int i = 0; i < 2000; ++i)
+  {
+    filenames.push_back("benchmark_batch_" + std::to_string(i) + ".qmlon");
+    std::ofstream out(filenames.back(), std::ios::out | std::ios::binary);
+    out << small;
+  }
+  for(unsigned int threads = 1; threads <= (cores > 4 ? cores : 4); threads *= 2)
+  {
+    qmlon::BatchLoader loader(threads);
+    measure("BatchLoader 2000 x spritesheet.qmlon, " + std::to_string(threads) + " threads", small.size() * filenames.size(), 1, [&]() { loader.load(filenames); });
+  }
+  for(std::string const& filename : filenames)
+  {
+    std::remove(filename.c_str());
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,60 @@
+#include "qmlon.h"
+#include "qmlonbinary.h"
+#include "check.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+bool throws(std::string const& data, bool verify = true)
+{
+  try
+  {
+    qmlon::readBinary(qmlon::Source::fromString(data), verify)->str();
+  }
+  catch(std::runtime_error const&)
+  {
+    return true;
+  }
+  return false;
+}
+
+int main(int argc, char** argv)
+{
+  bool ok = true;
+
+  qmlon::Value::Reference text = qmlon::readFile("spritesheet.qmlon");
+  std::string binary = qmlon::writeBinary(*text);
+  qmlon::Value::Reference compiled = qmlon::readBinary(qmlon::Source::fromString(binary));
+  ok &= check("magic", qmlon::isBinary(binary.data(), binary.size()));
+  ok &= check("spritesheet", compiled->str() == text->str());
+  ok &= check("rewritten", qmlon::writeBinary(*compiled) == binary);
+
+  qmlon::Value::Reference values = qmlon::readValue(
+    "Foo { b: false, i: -9223372036854775808, f: 0.1, s: \"a string longer than fourteen\", l: [[], [1, \"x\"], Bar {}], {} }");
+  qmlon::Value::Reference copy = qmlon::readBinary(qmlon::Source::fromString(qmlon::writeBinary(*values)));
+  qmlon::Object& foo = copy->asObject();
+  ok &= check("values", copy->str() == values->str());
+  ok &= check("exact numbers", foo.getProperty("i")->asInt64() == values->asObject().getProperty("i")->asInt64() && foo.getProperty("f")->asDouble() == 0.1);
+  ok &= check("scalar root", qmlon::readBinary(qmlon::Source::fromString(qmlon::writeBinary(qmlon::Value::createInteger(7))))->asInteger() == 7);
+
+  std::string flipped = binary;
+  flipped[flipped.size() / 2] ^= 1;
+  ok &= check("checksum", throws(flipped));
+  ok &= check("truncated", throws(binary.substr(0, binary.size() - 1), false));
+  std::string version = binary;
+  version[4] = 2;
+  ok &= check("version", throws(version));
+  ok &= check("text is not binary", !qmlon::isBinary("Foo {}", 6) && throws("Foo { a: \"long enough to not be binary\" }"));
+
+  // readFile recognizes compiled files
+  {
+    std::ofstream out("test_binary.qmlonb", std::ios::out | std::ios::binary);
+    qmlon::writeBinary(*text, out);
+  }
+  ok &= check("readFile", qmlon::readFile("test_binary.qmlonb")->str() == text->str());
+  ok &= check("readFileOnDemand", qmlon::readFileOnDemand("test_binary.qmlonb")->str() == text->str());
+  std::remove("test_binary.qmlonb");
+
+  return report(ok, "Binary documents round trip");
+}
@@ -0,0 +1,111 @@
+#include "qmlon.h"
+#include "qmloncache.h"
+#include "qmlonbinary.h"
+#include "check.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#include <utime.h>
+
+void write(std::string const& filename, std::string const& content)
+{
+  std::ofstream out(filename, std::ios::out | std::ios::binary);
+  out << content;
+}
+
+// Sets the modification time of a file, to change it without it showing
+void setModified(std::string const& filename, time_t modified)
+{
+  struct utimbuf times = {modified, modified};
+  utime(filename.c_str(), &times);
+}
+
+int main(int argc, char** argv)
+{
+  bool ok = true;
+
+  write("test_cache_a.qmlon", "Foo { a: 1 }");
+  setModified("test_cache_a.qmlon", 1000000000);
+  {
+    qmlon::DocumentCache cache;
+    qmlon::Value::Reference first = cache.get("test_cache_a.qmlon");
+    ok &= check("shared", cache.get("test_cache_a.qmlon") == first && cache.reads() == 1 && cache.count() == 1);
+
+    write("test_cache_a.qmlon", "Foo { a: 22 }");
+    ok &= check("size changed", cache.get("test_cache_a.qmlon")->asObject().getProperty("a")->asInteger() == 22 && cache.reads() == 2);
+    ok &= check("old root stays valid", first->asObject().getProperty("a")->asInteger() == 1);
+
+    cache.invalidate("test_cache_a.qmlon");
+    ok &= check("invalidate", cache.count() == 0 && cache.memoryUsage() == 0 && cache.get("test_cache_a.qmlon") && cache.reads() == 3);
+
+    bool threw = false;
+    try
+    {
+      cache.get("test_cache_missing.qmlon");
+    }
+    catch(std::runtime_error const&)
+    {
+      threw = true;
+    }
+    ok &= check("missing file", threw && cache.count() == 1);
+  }
+
+  // Content changes that keep the size and time only show in the hash
+  write("test_cache_a.qmlon", "Foo { a: 1 }");
+  setModified("test_cache_a.qmlon", 1000000000);
+  {
+    qmlon::DocumentCache cache(64 * 1024 * 1024, true);
+    qmlon::Value::Reference first = cache.get("test_cache_a.qmlon");
+    setModified("test_cache_a.qmlon", 1000000500);
+    ok &= check("touched", cache.get("test_cache_a.qmlon") == first && cache.reads() == 1);
+
+    write("test_cache_a.qmlon", "Foo { a: 2 }");
+    setModified("test_cache_a.qmlon", 1000000500);
+    ok &= check("hash changed", cache.get("test_cache_a.qmlon")->asObject().getProperty("a")->asInteger() == 2 && cache.reads() == 2);
+  }
+
+  // Concurrent requests for a file read it once
+  {
+    std::ofstream out("test_cache_b.qmlonb", std::ios::out | std::ios::binary);
+    qmlon::writeBinary(*qmlon::readFile("spritesheet.qmlon"), out);
+  }
+  {
+    qmlon::DocumentCache cache;
+    std::string expected = qmlon::readFile("spritesheet.qmlon")->str();
+    std::vector<std::string> results(8);
+    std::vector<std::thread> threads;
+    for(std::size_t i = 0; i < results.size(); ++i)
+    {
+      threads.emplace_back([&, i]() { results[i] = cache.get("test_cache_b.qmlonb")->str(); });
+    }
+    for(std::thread& thread : threads)
+    {
+      thread.join();
+    }
+
+    bool same = true;
+    for(std::string const& result : results)
+    {
+      same &= result == expected;
+    }
+    ok &= check("concurrent", same && cache.reads() == 1);
+  }
+
+  // Least recently used documents are dropped over the budget
+  {
+    qmlon::DocumentCache cache(1);
+    qmlon::Value::Reference a = cache.get("test_cache_a.qmlon");
+    qmlon::Value::Reference b = cache.get("test_cache_b.qmlonb");
+    ok &= check("budget", cache.count() == 1 && cache.get("test_cache_b.qmlonb") == b && cache.reads() == 2);
+    ok &= check("evicted", cache.get("test_cache_a.qmlon") != a && a->asObject().getProperty("a")->asInteger() == 2 && cache.reads() == 3);
+  }
+
+  std::remove("test_cache_a.qmlon");
+  std::remove("test_cache_b.qmlonb");
+
+  return report(ok, "Cached documents are shared and reread when changed");
+}
@@ -0,0 +1,28 @@
+#ifndef QMLON_TEST_CHECK_HH
+#define QMLON_TEST_CHECK_HH
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// Reports a failed check by name and returns the condition
+inline bool check(std::string const& name, bool condition)
+{
+  if(!condition)
+  {
+    std::cout << name << " failed" << std::endl;
+  }
+  return condition;
+}
+
+// Exit status of a test, printing the message if all checks passed
+inline int report(bool ok, std::string const& message)
+{
+  if(!ok)
+    return EXIT_FAILURE;
+
+  std::cout << message << std::endl;
+  return EXIT_SUCCESS;
+}
+
+#endif
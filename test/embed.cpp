@@ -0,0 +1,24 @@
+#include "qmlon.h"
+#include "spritesheet.h"
+#include "check.h"
+#include <cstdlib>
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+  bool ok = true;
+
+  qmlon::Value::Reference embedded = spritesheet();
+  qmlon::Value::Reference read = qmlon::readFile("spritesheet.qmlon");
+  ok &= check("same document", embedded->str() == read->str());
+
+  qmlon::Object& sheet = embedded->asObject();
+  ok &= check("read API", sheet.getProperty("image")->asString() == "player.png"
+    && sheet.children[0]->children[2]->children[1]->getProperty("hotspot")->asObject().getProperty("y")->asInteger() == 16);
+
+  // Each call gives a document of its own over the same data
+  qmlon::Value::Reference again = spritesheet();
+  ok &= check("again", again.get() != embedded.get() && again->str() == read->str());
+
+  return report(ok, "Embedded document matches the file");
+}
@@ -0,0 +1,63 @@
+#include "qmlon.h"
+#include "qmlonlexer.h"
+#include "qmlonwriter.h"
+#include "check.h"
+#include <cstdlib>
+#include <iostream>
+
+std::string decode(std::string const& literal)
+{
+  return qmlon::readValue(literal)->asString();
+}
+
+bool throws(std::string const& literal)
+{
+  try
+  {
+    qmlon::readValue(literal);
+  }
+  catch(qmlon::SyntaxError const&)
+  {
+    return true;
+  }
+  return false;
+}
+
+int main(int argc, char** argv)
+{
+  bool ok = true;
+
+  ok &= check("simple escapes", decode("\"\\\"\\\\\\/\\b\\f\\n\\r\\t\"") == "\"\\/\b\f\n\r\t");
+  ok &= check("unicode", decode("\"\\u0041\\u00e9\\u20AC\"") == "A\xc3\xa9\xe2\x82\xac");
+  ok &= check("surrogate pair", decode("\"\\ud83d\\ude00\"") == "\xf0\x9f\x98\x80");
+  ok &= check("raw UTF-8", decode("\"\xc3\xa9\"") == "\xc3\xa9");
+  ok &= check("escapes among text", decode("\"a long line\\nand another long line\"") == "a long line\nand another long line");
+
+  ok &= check("invalid escapes", throws("\"\\q\"") && throws("\"\\u12\"") && throws("\"\\u12g4\"") && throws("\"\\ud83d\"")
+    && throws("\"\\ud83dx\"") && throws("\"\\ude00\"") && throws("\"\\"));
+
+  // Strings without escapes refer to the source, decoded ones to the
+  // document
+  qmlon::Source::Reference source = qmlon::Source::fromString("Foo { a: \"a string without escapes\", b: \"a string \\\"with\\\" escapes\" }");
+  qmlon::Document::Reference document = qmlon::readDocument(source);
+  qmlon::Object& foo = document->getRoot()->asObject();
+  char const* a = foo.getProperty("a")->asStringRef().data();
+  char const* b = foo.getProperty("b")->asStringRef().data();
+  ok &= check("no copy", a >= source->data() && a < source->data() + source->length());
+  ok &= check("decoded", (b < source->data() || b >= source->data() + source->length())
+    && foo.getProperty("b")->asString() == "a string \"with\" escapes");
+
+  qmlon::Value::Reference onDemand = qmlon::readValueOnDemand(source);
+  ok &= check("on demand", onDemand->asObject().getProperty("b")->asString() == "a string \"with\" escapes");
+
+  qmlon::Value::Reference values = qmlon::readValue("[\"first \\t long string\", \"second \\t long string\", \"x\\ty\"]");
+  ok &= check("buffer reused", values->asList()[0].asString() == "first \t long string"
+    && values->asList()[1].asString() == "second \t long string" && values->asList()[2].asString() == "x\ty");
+
+  // Written strings read back the same
+  std::string text = "quote \" backslash \\ newline \n tab \t control \x01 text \xc3\xa9";
+  qmlon::Value::Reference written = qmlon::readValue("Foo { s: " + qmlon::writeText(qmlon::Value::createString(text)) + " }");
+  ok &= check("round trip", written->asObject().getProperty("s")->asString() == text);
+
+  return report(ok, "Escapes are decoded");
+}
@@ -0,0 +1,56 @@
+#include "qmlon.h"
+#include "check.h"
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+
+// Records the events as text
+class Recorder : public qmlon::Handler
+{
+public:
+  void onObjectStart(qmlon::Atom type) { out << type << "{ "; }
+  void onObjectEnd() { out << "} "; }
+  void onProperty(qmlon::Atom name) { out << name << ": "; }
+  void onListStart() { out << "[ "; }
+  void onListEnd() { out << "] "; }
+  void onValue(qmlon::Value const& value) { out << value.str() << " "; }
+
+  std::ostringstream out;
+};
+
+// Counts objects of one type, like a consumer that only needs a summary
+class Counter : public qmlon::Handler
+{
+public:
+  Counter(std::string const& type) : type(type), count(0) {}
+  void onObjectStart(qmlon::Atom t) { if(t == type) ++count; }
+
+  qmlon::Atom type;
+  int count;
+};
+
+int main(int argc, char** argv)
+{
+  bool ok = true;
+
+  Recorder recorder;
+  qmlon::parse(std::string("Foo { a: 1, l: [true, \"s\", Bar {}], Baz { b: 2.5 } {} }"), recorder);
+  ok &= check("events", recorder.out.str() == "Foo{ a: 1 l: [ true \"s\" Bar{ } ] Baz{ b: 2.5 } { } } ");
+
+  Counter counter("Frame");
+  qmlon::parse(std::string("Sheet { Frame {}, Frame { Frame {} }, first: Frame {}, frames: [Frame {}] }"), counter);
+  ok &= check("count", counter.count == 5);
+
+  try
+  {
+    Recorder broken;
+    qmlon::parse(std::string("Foo { a 1 }"), broken);
+    ok &= check("syntax error throws", false);
+  }
+  catch(std::runtime_error const& e)
+  {
+    ok &= check("syntax error message", std::string(e.what()) == "ERROR: Expected property or child object at line 1 character 9");
+  }
+
+  return report(ok, "Handlers receive the expected events");
+}
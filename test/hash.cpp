@@ -0,0 +1,71 @@
+#include "qmlon.h"
+#include "qmlonhash.h"
+#include "check.h"
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+bool same(std::string const& a, std::string const& b)
+{
+  qmlon::Value::Reference x = qmlon::readValue(a);
+  qmlon::Value::Reference y = qmlon::readValue(b);
+  return qmlon::structurallyEqual(*x, *y) && qmlon::structuralHash(*x) == qmlon::structuralHash(*y);
+}
+
+bool differ(std::string const& a, std::string const& b)
+{
+  return !qmlon::structurallyEqual(*qmlon::readValue(a), *qmlon::readValue(b));
+}
+
+int main(int argc, char** argv)
+{
+  bool ok = true;
+
+  ok &= check("scalars", same("1", "1") && same("\"a string longer than inline\"", "\"a string longer than inline\"")
+    && differ("1", "1.0") && differ("1", "true") && differ("\"a\"", "\"b\""));
+  ok &= check("objects", same("Foo { a: 1, b: [1, 2], Bar {} }", "Foo {\n  a: 1\n  b: [1, 2]\n  Bar {}\n}")
+    && differ("Foo { a: 1, b: 2 }", "Foo { b: 2, a: 1 }") && differ("Foo { a: 1 }", "Bar { a: 1 }")
+    && differ("Foo { Bar {} }", "Foo { Baz {} }") && differ("Foo { a: [1] }", "Foo { a: [1, 1] }"));
+
+  // Equal subtrees of a deduplicated document are the same objects
+  qmlon::Source::Reference source = qmlon::Source::fromFile("spritesheet.qmlon");
+  qmlon::Value::Reference plain = qmlon::readValue(source);
+  qmlon::Value::Reference deduplicated = qmlon::readValueDeduplicated(source);
+  ok &= check("same document", plain->str() == deduplicated->str() && qmlon::structurallyEqual(*plain, *deduplicated));
+
+  qmlon::Object const& sprite = *deduplicated->asObject().children[0];
+  qmlon::Object const& walk = *sprite.children[0]->children[0];
+  qmlon::Object const& jump = *sprite.children[1]->children[0];
+  qmlon::Object const& crouch = *sprite.children[2]->children[1];
+  ok &= check("shared objects", &walk.getProperty("size")->asObject() == &jump.getProperty("size")->asObject()
+    && &walk.getProperty("size")->asObject() == &crouch.getProperty("size")->asObject()
+    && &walk.getProperty("hotspot")->asObject() == &jump.getProperty("hotspot")->asObject());
+  ok &= check("distinct objects", &walk.getProperty("position")->asObject() != &jump.getProperty("position")->asObject()
+    && &walk.getProperty("hotspot")->asObject() != &crouch.getProperty("hotspot")->asObject());
+
+  // Long strings and lists are shared too, also when decoded from escapes
+  qmlon::Value::Reference values = qmlon::readValueDeduplicated(qmlon::Source::fromString(
+    "[\"a long string in the source\", \"a long string in the source\", \"a \\\"long\\\" escaped string\","
+    " \"a \\\"long\\\" escaped string\", [1, 2, 3], [1, 2, 3], [1, 2]]"));
+  qmlon::Value::List const& list = values->asList();
+  ok &= check("shared strings", list[0].asStringRef().data() == list[1].asStringRef().data()
+    && list[2].asStringRef().data() == list[3].asStringRef().data() && list[3].asString() == "a \"long\" escaped string");
+  ok &= check("shared lists", &list[4].asList() == &list[5].asList() && &list[5].asList() != &list[6].asList());
+
+  // Repetitive documents take less memory
+  std::ostringstream level;
+  level << "Level {\n";
+  for(int i = 0; i < 2000; ++i)
+  {
+    level << "  Tile { position: Vec2D { x: " << i % 100 << ", y: " << i / 100 << " }, size: Size { width: 32, height: 32 },"
+          << " kind: \"grass with \\\"flowers\\\"\", tags: [\"walkable\", \"outdoor\"], Animation { frames: [0, 1, 2, 3] } }\n";
+  }
+  level << "}\n";
+  qmlon::Source::Reference levelSource = qmlon::Source::fromString(level.str());
+  qmlon::Document::Reference full = qmlon::readDocument(levelSource);
+  qmlon::Document::Reference shared = qmlon::readDocumentDeduplicated(levelSource);
+  ok &= check("same level", full->getRoot()->str() == shared->getRoot()->str());
+  ok &= check("less memory", shared->getArena().capacity() < full->getArena().capacity());
+
+  return report(ok, "Equal values are shared");
+}
@@ -0,0 +1,86 @@
+#include "qmlonparser.h"
+#include "check.h"
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <cstdlib>
+
+std::vector<std::string> parseInChunks(std::string const& input, std::size_t chunkSize)
+{
+  std::vector<std::string> values;
+  qmlon::IncrementalParser parser([&](qmlon::Value::Reference value) {
+    values.push_back(value->str());
+  });
+
+  for(std::size_t i = 0; i < input.size(); i += chunkSize)
+  {
+    parser.feed(input.data() + i, std::min(chunkSize, input.size() - i));
+  }
+  parser.finish();
+
+  return values;
+}
+
+// Whether the input gives the expected values with every chunk size
+bool parsesInAllChunkSizes(std::string const& input, std::vector<std::string> const& expected)
+{
+  for(std::size_t chunkSize = 1; chunkSize <= input.size(); ++chunkSize)
+  {
+    if(parseInChunks(input, chunkSize) != expected)
+    {
+      std::cout << "Values differ when fed in chunks of " << chunkSize << " bytes" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char** argv)
+{
+  bool ok = true;
+
+  std::ifstream f("spritesheet.qmlon");
+  std::string document = qmlon::readAll(f);
+  ok &= check("sprite sheet", parsesInAllChunkSizes(document, {qmlon::readValue(document)->str()}));
+
+  std::string sequence = "// values\n 12, -1.5 true \"a \\\" b\" [1, /* ] */ 2]\nFoo /* { */ { s: \"}\" } {}\n7";
+  std::vector<std::string> expected;
+  for(std::string value : {"12", "-1.5", "true", "\"a \\\" b\"", "[1, 2]", "Foo { s: \"}\" }", "{}", "7"})
+  {
+    expected.push_back(qmlon::readValue(value)->str());
+  }
+  ok &= check("value sequence", parsesInAllChunkSizes(sequence, expected));
+
+  // Values are reported before the rest of the input has been fed
+  int count = 0;
+  qmlon::IncrementalParser parser([&](qmlon::Value::Reference) { ++count; });
+  parser.feed("A {}\nB { x: ");
+  ok &= check("first value reported early", count == 1);
+
+  // Errors are reported at their position in the whole input
+  std::string error;
+  try
+  {
+    parser.feed("1 }\nC {\n  y: ]\n}");
+  }
+  catch(std::runtime_error const& e)
+  {
+    error = e.what();
+  }
+  ok &= check("invalid value position", error.find("line 4 character 6") != std::string::npos);
+
+  bool threw = false;
+  try
+  {
+    qmlon::IncrementalParser truncated([](qmlon::Value::Reference) {});
+    truncated.feed("A { x: \"abc");
+    truncated.finish();
+  }
+  catch(qmlon::SyntaxError const&)
+  {
+    threw = true;
+  }
+  ok &= check("truncated input", threw);
+
+  return report(ok, "Incremental parsing works with all chunk sizes");
+}
@@ -8,7 +8,7 @@ std::string const SYMBOL_NAMES[] = {
   "OBJECT_START", "OBJECT_END", "LIST_START", "LIST_END", 
   "VALUE_SEPARATOR", "KEY_VALUE_SEPARATOR", 
   "INTEGER", "FLOAT", "BOOLEAN", "IDENTIFIER", "STRING",
-  "UNKNOWN"
+  "UNKNOWN", "END_OF_INPUT"
 };
 
 int main()
@@ -17,11 +17,13 @@ int main()
   
   try
   {
-    qmlon::SymbolSequence symbols = qmlon::lex(stream);
+    qmlon::Lexer lexer(stream);
     
-    for(qmlon::Symbol const& symbol : symbols)
+    while(lexer.peek().type != qmlon::END_OF_INPUT)
     {
-      std::cout << symbol.position.line << ":" << symbol.position.lineCharacter << " " << SYMBOL_NAMES[symbol.type] << ": '" << symbol.content << "'" << std::endl;
+      qmlon::Symbol const& symbol = lexer.next();
+      qmlon::StreamPosition position = lexer.position(symbol);
+      std::cout << position.line << ":" << position.lineCharacter << " " << SYMBOL_NAMES[symbol.type] << ": '" << symbol.content << "'" << std::endl;
     }
   }
   catch(qmlon::SyntaxError e)
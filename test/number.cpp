@@ -0,0 +1,82 @@
+#include "qmlon.h"
+#include "qmlonnumber.h"
+#include "check.h"
+#include <iostream>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+
+bool same(double a, double b)
+{
+  return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+double toDouble(std::string const& text)
+{
+  double result = -1;
+  qmlon::fromChars(text.data(), text.data() + text.size(), result);
+  return result;
+}
+
+bool throws(std::string const& input)
+{
+  try
+  {
+    qmlon::readValue(input);
+  }
+  catch(std::runtime_error const&)
+  {
+    return true;
+  }
+  return false;
+}
+
+int main(int argc, char** argv)
+{
+  bool ok = true;
+
+  ok &= check("simple", toDouble("2.5") == 2.5 && toDouble("-0.125") == -0.125 && toDouble(".5") == 0.5 && toDouble("3.") == 3.0);
+  ok &= check("negative zero", same(toDouble("-0.0"), -0.0));
+  ok &= check("closest double", toDouble("0.1") == 0.1 && toDouble("0.30000000000000004") == 0.30000000000000004);
+  ok &= check("many digits", toDouble("3.14159265358979323846264338327950288") == 3.141592653589793);
+  ok &= check("halfway rounds to even", toDouble("9007199254740993") == 9007199254740992.0);
+  ok &= check("beyond halfway", toDouble("9007199254740993.0000000000000000001") == 9007199254740994.0);
+  ok &= check("smallest subnormal", toDouble("0." + std::string(323, '0') + "5") == std::numeric_limits<double>::denorm_min());
+  ok &= check("largest", toDouble("179769313486231570" + std::string(291, '0')) == std::numeric_limits<double>::max());
+
+  // Printed with enough digits, every double reads back exactly
+  std::mt19937_64 random(1);
+  bool roundTrip = true;
+  for(int i = 0; i < 100000; ++i)
+  {
+    double d = std::ldexp(static_cast<double>(random() >> 11), static_cast<int>(random() % 120) - 100);
+    char text[512];
+    std::snprintf(text, sizeof(text), "%.*f", 120, d);
+    roundTrip &= same(toDouble(text), d);
+  }
+  ok &= check("round trip", roundTrip);
+
+  qmlon::Value::Reference root = qmlon::readValue("Foo { big: 9223372036854775807, small: -9223372036854775808, f: 0.1 }");
+  qmlon::Object& foo = root->asObject();
+  int i = 0;
+  ok &= check("int64", foo.getProperty("big")->asInt64() == std::numeric_limits<std::int64_t>::max());
+  ok &= check("int64 min", foo.getProperty("small")->asInt64() == std::numeric_limits<std::int64_t>::min());
+  ok &= check("double", foo.getProperty("f")->asDouble() == 0.1 && foo.getProperty("f")->asFloat() == 0.1f);
+  ok &= check("narrowing", !foo.getProperty("big")->tryAsInteger(i) && foo.getProperty("big")->asDouble() == 9223372036854775807.0);
+  ok &= check("overflow", throws("9223372036854775808") && throws("-9223372036854775809") && !throws("-9223372036854775808"));
+  ok &= check("invalid numbers", throws("-") && throws(".") && throws("1.2.3"));
+
+  try
+  {
+    foo.getProperty("big")->asInteger();
+    ok &= check("narrowing throws", false);
+  }
+  catch(std::range_error const&)
+  {
+  }
+
+  return report(ok, "Numbers are read correctly");
+}
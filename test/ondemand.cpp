@@ -0,0 +1,41 @@
+#include "qmlon.h"
+#include "check.h"
+#include <iostream>
+#include <cstdlib>
+
+bool throws(std::string const& input, bool touch)
+{
+  try
+  {
+    qmlon::Value::Reference value = qmlon::readValueOnDemand(qmlon::Source::fromString(input));
+    if(touch)
+    {
+      value->str();
+    }
+  }
+  catch(std::runtime_error const&)
+  {
+    return true;
+  }
+  return false;
+}
+
+int main(int argc, char** argv)
+{
+  bool ok = true;
+
+  qmlon::Value::Reference full = qmlon::readFile("spritesheet.qmlon");
+  qmlon::Value::Reference lazy = qmlon::readFileOnDemand("spritesheet.qmlon");
+  ok &= check("spritesheet", lazy->str() == full->str());
+
+  std::string tricky = "Foo { s: \"} { [\\\" ]\", /* } */ l: [1, [2, {}], Bar { a: \"]\" }] // }\n Baz { {} } }";
+  ok &= check("brackets in strings and comments", qmlon::readValueOnDemand(qmlon::Source::fromString(tricky))->str() == qmlon::readValue(tricky)->str());
+
+  qmlon::Value::Reference root = qmlon::readValueOnDemand(qmlon::Source::fromString("Root { Skipped { x: 1 y } Used { x: 2 } }"));
+  qmlon::Object& used = *root->asObject().children[1];
+  ok &= check("untouched subtree is not read", used.type == "Used" && used.getProperty("x")->asInteger() == 2);
+  ok &= check("error when touched", throws("Root { Skipped { x: 1 y } }", true) && !throws("Root { Skipped { x: 1 y } }", false));
+  ok &= check("unbalanced brackets", throws("Root { a: [1 }", false) && throws("Root { a: 1 ", false));
+
+  return report(ok, "Documents read on demand match fully read ones");
+}
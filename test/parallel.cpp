@@ -0,0 +1,67 @@
+#include "qmlon.h"
+#include "check.h"
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+
+std::string error(std::function<void()> f)
+{
+  try
+  {
+    f();
+  }
+  catch(std::runtime_error const& e)
+  {
+    return e.what();
+  }
+  return "";
+}
+
+// A document large enough to be read in parallel, with brackets in strings
+// and comments and members of every kind at the top level
+std::string generateDocument(int items)
+{
+  std::ostringstream ss;
+  ss << "Root {\n";
+  for(int i = 0; i < items; ++i)
+  {
+    ss << "  p" << i << ": " << i << ",\n"
+       << "  // } comment {\n"
+       << "  Item { id: \"item" << i << " } [\", l: [1, [2], Point { x: " << i << " }] }\n"
+       << "  /* ] */ l" << i << ": [\"{\", " << i << ".5]\n"
+       << "  o" << i << ": { a: \"]\" }\n"
+       << "  { }\n";
+  }
+  ss << "}\n";
+  return ss.str();
+}
+
+int main(int argc, char** argv)
+{
+  bool ok = true;
+
+  std::string text = generateDocument(10000);
+  qmlon::Source::Reference source = qmlon::Source::fromString(text);
+  std::string expected = qmlon::readValue(source)->str();
+  for(unsigned int threads = 1; threads <= 8; ++threads)
+  {
+    ok &= check("same document with " + std::to_string(threads) + " threads", qmlon::readValueParallel(source, threads)->str() == expected);
+  }
+
+  qmlon::Value::Reference root = qmlon::readValueParallel(source, 4);
+  qmlon::Object& object = root->asObject();
+  ok &= check("type", object.type == "Root");
+  ok &= check("member order", object.properties.size() == 30000 && object.children.size() == 20000
+    && object.children[19998]->getProperty("id")->asString() == "item9999 } [");
+
+  ok &= check("small document", qmlon::readValueParallel(qmlon::Source::fromString("Foo { a: 1, Bar {} }"), 4)->str() == "Foo {\n  a: 1\n  Bar {}\n}");
+  ok &= check("scalar root", qmlon::readValueParallel(qmlon::Source::fromString(std::string(300000, ' ') + "42"), 4)->asInteger() == 42);
+
+  std::string broken = text;
+  broken.replace(broken.find("p9000:"), 6, "p9000 ");
+  std::string message = error([&]() { qmlon::readValue(broken); });
+  ok &= check("error position", !message.empty() && error([&]() { qmlon::readValueParallel(qmlon::Source::fromString(broken), 4); }) == message);
+
+  return report(ok, "Documents read in parallel match ones read in one piece");
+}
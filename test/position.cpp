@@ -0,0 +1,88 @@
+#include "qmlon.h"
+#include "qmlonlexer.h"
+#include "check.h"
+#include <stdexcept>
+
+// Whether reading the text fails at the given position
+bool failsAt(std::string const& text, unsigned int character, unsigned int line, unsigned int lineCharacter)
+{
+  try
+  {
+    qmlon::readValue(text);
+  }
+  catch(qmlon::SyntaxError const& e)
+  {
+    if(e.position.character != character || e.position.line != line || e.position.lineCharacter != lineCharacter)
+    {
+      std::cout << e.what() << " at " << e.position.character << ", line " << e.position.line << ":" << e.position.lineCharacter << std::endl;
+      return false;
+    }
+    return true;
+  }
+  return false;
+}
+
+// Whether the parser rejects the text at the line and character given in
+// its message, which counts them from one
+bool rejectedAt(std::string const& text, std::string const& where)
+{
+  try
+  {
+    qmlon::readValue(text);
+  }
+  catch(qmlon::SyntaxError const&)
+  {
+    return false;
+  }
+  catch(std::runtime_error const& e)
+  {
+    std::string message = e.what();
+    return message.size() >= where.size() && message.compare(message.size() - where.size(), where.size(), where) == 0;
+  }
+  return false;
+}
+
+// Whether the symbol with the content is at the given position
+bool symbolAt(std::string const& text, std::string const& content, unsigned int character, unsigned int line, unsigned int lineCharacter)
+{
+  qmlon::Lexer lexer(text.data(), text.length(), qmlon::StreamPosition());
+  while(lexer.peek().type != qmlon::END_OF_INPUT)
+  {
+    qmlon::Symbol const& symbol = lexer.next();
+    if(symbol.content == qmlon::StringRef(content))
+    {
+      qmlon::StreamPosition position = lexer.position(symbol);
+      return position.character == character && position.line == line && position.lineCharacter == lineCharacter;
+    }
+  }
+  return false;
+}
+
+int main(int argc, char** argv)
+{
+  bool ok = true;
+
+  // Lines and characters are counted from zero, characters in bytes
+  ok &= check("first line", failsAt("Foo { a: @ }", 9, 0, 9));
+  ok &= check("later line", failsAt("Foo {\n  a: 1\n  b: @\n}", 18, 2, 5));
+  ok &= check("after CRLF", failsAt("Foo {\r\n  a: 1\r\n  b: @\r\n}", 20, 2, 5));
+  ok &= check("lexer error", failsAt("Foo {\n  s: \"ab\\q\"\n}", 14, 1, 8));
+  ok &= check("lexer error after CRLF", failsAt("Foo {\r\n  s: \"ab\\q\"\r\n}", 15, 1, 8));
+  ok &= check("unterminated string", failsAt("Foo {\r\n  a: \"abc\r\n}", 12, 1, 5));
+
+  ok &= check("parser error on first line", rejectedAt("Foo { a: 1 2 }", "at line 1 character 12"));
+  ok &= check("parser error after CRLF", rejectedAt("Foo {\r\n  a: 1\r\n  b: 1 2\r\n}", "at line 3 character 8"));
+  ok &= check("end of input", rejectedAt("Foo {\n  a: 1\n", "at line 3 character 1"));
+
+  // Later symbols may be resolved before earlier ones
+  std::string text = "Foo {\r\n  bar: 1\r\n  baz: [2, 3]\r\n}";
+  ok &= check("symbol on first line", symbolAt(text, "Foo", 0, 0, 0));
+  ok &= check("symbol after CRLF", symbolAt(text, "bar", 9, 1, 2) && symbolAt(text, "baz", 19, 2, 2) && symbolAt(text, "3", 28, 2, 11));
+  qmlon::Lexer lexer(text.data(), text.length(), qmlon::StreamPosition());
+  qmlon::Symbol foo = lexer.next();
+  lexer.next();
+  qmlon::Symbol bar = lexer.next();
+  ok &= check("out of order", lexer.position(bar).line == 1 && lexer.position(foo).line == 0 && lexer.position(foo).lineCharacter == 0);
+
+  return report(ok, "Positions are reported correctly");
+}
@@ -0,0 +1,51 @@
+#include "qmlon.h"
+#include "check.h"
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+
+int main(int argc, char** argv)
+{
+  bool ok = true;
+
+  qmlon::Value::Reference small = qmlon::readValue("Foo { z: 1, a: 2, m: 3, a: 4 }");
+  qmlon::Object& foo = small->asObject();
+  std::string order;
+  for(auto const& property : foo.properties)
+  {
+    order += property.first.str();
+  }
+  ok &= check("source order", order == "zam");
+  ok &= check("duplicate replaces value", foo.properties.size() == 3 && foo.getProperty("a")->asInteger() == 4);
+  ok &= check("missing", !foo.hasProperty("b") && foo.properties.find(qmlon::Atom("b")) == foo.properties.end()
+    && foo.getProperty("b") == nullptr && foo.getProperty("no property has this name") == nullptr);
+
+  // Enough properties to switch to the hashed index
+  int const count = 100;
+  std::ostringstream ss;
+  ss << "Bar {";
+  for(int i = 0; i < count; ++i)
+  {
+    ss << " p" << i << ": " << i << ",";
+  }
+  ss << " p7: -7 }";
+
+  qmlon::Value::Reference large = qmlon::readValue(ss.str());
+  qmlon::Object& bar = large->asObject();
+  ok &= check("indexed size", bar.properties.size() == static_cast<std::size_t>(count));
+
+  bool found = true;
+  int position = 0;
+  for(auto const& property : bar.properties)
+  {
+    std::ostringstream name;
+    name << "p" << position;
+    found &= property.first == name.str();
+    found &= bar.hasProperty(name.str()) && bar.getProperty(name.str())->asInteger() == (position == 7 ? -7 : position);
+    ++position;
+  }
+  ok &= check("indexed lookup", found);
+  ok &= check("indexed missing", !bar.hasProperty("q1") && !bar.hasProperty(qmlon::Atom("p100")));
+
+  return report(ok, "Properties behave correctly");
+}
@@ -0,0 +1,79 @@
+#include "qmlon.h"
+#include "qmlonquery.h"
+#include "check.h"
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+bool throws(std::string const& path)
+{
+  try
+  {
+    qmlon::Query query(path);
+  }
+  catch(qmlon::SyntaxError const&)
+  {
+    return true;
+  }
+  return false;
+}
+
+std::string generateDocument(int sprites)
+{
+  std::ostringstream ss;
+  ss << "Sheet {\n";
+  for(int i = 0; i < sprites; ++i)
+  {
+    ss << "  Sprite { id: \"sprite" << i << "\", index: " << i
+       << ", Animation { id: \"walk\", fps: " << i % 3 << " }, Animation { id: \"jump\" } }\n";
+  }
+  ss << "}\n";
+  return ss.str();
+}
+
+int main(int argc, char** argv)
+{
+  bool ok = true;
+
+  qmlon::Value::Reference sheet = qmlon::readFile("spritesheet.qmlon");
+  qmlon::Object const& root = sheet->asObject();
+  qmlon::ChildIndex index;
+
+  qmlon::Query frames("Sprite[id=\"player\"]/Animation/Frames");
+  std::vector<qmlon::Object*> result = frames.select(root);
+  ok &= check("select", result.size() == 2 && result[0]->getProperty("count")->asInteger() == 3
+    && result[1] == root.children[0]->children[1]->children[0]);
+  ok &= check("select with index", frames.select(root, &index) == result);
+  ok &= check("first", frames.first(root) == result[0] && frames.first(root, &index) == result[0]);
+
+  qmlon::Query crouch("Sprite/Animation[id=\"crouch\"]/Frame");
+  ok &= check("condition", crouch.select(root).size() == 2 && crouch.select(root, &index) == crouch.select(root));
+  ok &= check("any type", qmlon::Query("*/*/*").select(root).size() == 4 && qmlon::Query("*/*/*").select(root, &index).size() == 4);
+  ok &= check("no match", qmlon::Query("Sprite[id=\"enemy\"]/Animation").select(root, &index).empty()
+    && !qmlon::Query("Sprite/Animation[fps=\"30\"]").first(root, &index));
+
+  qmlon::Value::Reference numbers = qmlon::readValue("Root { A { x: 1 }, A { x: 1.0 }, A { x: 2 }, A { x: true }, A { x: 1, y: \"a\" } }");
+  qmlon::Query one("A[x=1]");
+  qmlon::Query oneFloat("A[x=1.0]");
+  ok &= check("numbers", one.select(numbers->asObject()).size() == 3 && oneFloat.select(numbers->asObject()).size() == 3
+    && one.select(numbers->asObject(), &index).size() == 3 && oneFloat.select(numbers->asObject(), &index).size() == 3);
+  ok &= check("several conditions", qmlon::Query("A[x=1][y=\"a\"]").select(numbers->asObject(), &index).size() == 1
+    && qmlon::Query("A[y=\"a\"][x=1.0]").select(numbers->asObject()).size() == 1);
+  ok &= check("boolean", qmlon::Query("A[x=true]").select(numbers->asObject(), &index).size() == 1);
+
+  ok &= check("syntax errors", throws("") && throws("Sprite/") && throws("Sprite[id]") && throws("Sprite[id=]")
+    && throws("Sprite[id=\"player\"") && throws("Sprite[id=Foo]") && throws("Sprite Animation") && throws("/Sprite"));
+
+  // One query on many documents
+  qmlon::Query walk("Sprite[index=1500]/Animation[id=\"walk\"]");
+  qmlon::Value::Reference a = qmlon::readValue(generateDocument(2000));
+  qmlon::Value::Reference b = qmlon::readValue(generateDocument(3000));
+  qmlon::ChildIndex shared;
+  qmlon::Object* inA = walk.first(a->asObject(), &shared);
+  qmlon::Object* inB = walk.first(b->asObject(), &shared);
+  ok &= check("many documents", inA && inB && inA != inB && inA->getProperty("fps")->asInteger() == 0
+    && inA == walk.first(a->asObject()) && inB == walk.first(b->asObject()));
+  ok &= check("many selected", qmlon::Query("Sprite/Animation[fps=2]").select(b->asObject(), &shared).size() == 1000);
+
+  return report(ok, "Queries select the expected objects");
+}
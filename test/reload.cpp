@@ -0,0 +1,100 @@
+#include "qmlon.h"
+#include "qmlonreload.h"
+#include "check.h"
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+std::string generateDocument(int sprites)
+{
+  std::ostringstream ss;
+  ss << "Sheet {\n  image: \"sheet.png\"\n";
+  for(int i = 0; i < sprites; ++i)
+  {
+    ss << "  Sprite {\n    id: \"sprite" << i << "\"\n";
+    for(int j = 0; j < 3; ++j)
+    {
+      ss << "    Animation { id: \"animation" << j << "\", fps: " << 10 + j
+         << ", frames: [Frame { x: 0 }, Frame { x: 32 }] }\n";
+    }
+    ss << "  }\n";
+  }
+  ss << "}\n";
+  return ss.str();
+}
+
+// Replaces the first occurrence of from after anchor
+std::string replace(std::string text, std::string const& from, std::string const& to, std::string const& anchor = "")
+{
+  return text.replace(text.find(from, text.find(anchor)), from.length(), to);
+}
+
+// Reloads a new version and checks that the document matches a full read
+bool reload(qmlon::Reloader& reloader, std::string const& text, std::vector<qmlon::Change>& changes)
+{
+  changes = reloader.reload(qmlon::Source::fromString(text));
+  return reloader.getRoot()->str() == qmlon::readValue(text)->str();
+}
+
+int main(int argc, char** argv)
+{
+  bool ok = true;
+  std::vector<qmlon::Change> changes;
+
+  std::string text = generateDocument(2000);
+  qmlon::Reloader reloader(qmlon::Source::fromString(text));
+  qmlon::Value::Reference first = reloader.getRoot();
+
+  text = replace(text, "fps: 11", "fps: 24", "\"sprite1500\"");
+  ok &= check("changed property", reload(reloader, text, changes) && changes.size() == 1
+    && changes[0].kind == qmlon::Change::CHANGED && changes[0].path == "Sprite[1500]/Animation[1]/fps"
+    && changes[0].after->getProperty("fps")->asInteger() == 24 && changes[0].before->getProperty("fps")->asInteger() == 11);
+  ok &= check("work scales with the edit", reloader.getParsed() < 200);
+  ok &= check("previous version", first->asObject().children[1500]->children[1]->getProperty("fps")->asInteger() == 11);
+  ok &= check("unchanged objects are shared", reloader.getRoot()->asObject().children[1499] == first->asObject().children[1499]);
+
+  text = replace(text, "\"sprite20\"\n", "\"sprite20\"\n    Animation { id: \"new\" }\n");
+  ok &= check("added object", reload(reloader, text, changes) && changes.size() == 1
+    && changes[0].kind == qmlon::Change::ADDED && changes[0].path == "Sprite[20]/Animation[0]" && !changes[0].before);
+
+  text = replace(text, "image: \"sheet.png\"\n", "");
+  ok &= check("removed property", reload(reloader, text, changes) && changes.size() == 1
+    && changes[0].kind == qmlon::Change::REMOVED && changes[0].property == "image");
+
+  text = replace(text, "\"sprite7\"\n", "\"sprite7\"   // comment\n");
+  ok &= check("whitespace and comments", reload(reloader, text, changes) && changes.empty());
+
+  std::string commented = replace(text, "\"sprite8\"\n", "\"sprite8\" /*\n");
+  bool threw = false;
+  try
+  {
+    reloader.reload(qmlon::Source::fromString(commented));
+  }
+  catch(std::runtime_error const&)
+  {
+    threw = true;
+  }
+  ok &= check("syntax error keeps the previous version", threw && reloader.getRoot()->str() == qmlon::readValue(text)->str());
+
+  text = replace(text, "\"sprite9\"\n    Animation", "\"sprite9\"\n    // Animation");
+  ok &= check("edit moving the end of an object", reload(reloader, text, changes));
+
+  for(int i = 0; i < 50; ++i)
+  {
+    std::string id = "\"sprite" + std::to_string(i * 37) + "\"";
+    text = replace(text, id, id + ", extra: " + std::to_string(i));
+    ok &= check("edit " + std::to_string(i), reload(reloader, text, changes) && changes.size() == 1 && changes[0].kind == qmlon::Change::ADDED);
+  }
+
+  text = replace(text, "Sheet {", "Atlas {");
+  ok &= check("root type", reload(reloader, text, changes) && changes.size() == 1 && changes[0].path == "");
+
+  // Documents read separately
+  qmlon::Value::Reference a = qmlon::readValue("Root { x: 1, A {}, B { y: 1 }, C {}, D {} }");
+  qmlon::Value::Reference b = qmlon::readValue("Root { x: 1, A {}, Z {}, B { y: 2 }, C {}, D {} }");
+  changes = qmlon::diff(*a, *b);
+  ok &= check("diff", changes.size() == 2 && changes[0].kind == qmlon::Change::ADDED && changes[0].path == "Z[1]"
+    && changes[1].kind == qmlon::Change::CHANGED && changes[1].path == "B[2]/y");
+
+  return report(ok, "Reloaded documents match full reads");
+}
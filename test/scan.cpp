@@ -0,0 +1,67 @@
+#include "qmlonscan.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+typedef char const* (*ScanFunction)(char const*, char const*);
+
+bool compare(char const* name, std::string const& input, ScanFunction expected, ScanFunction actual)
+{
+  // Scan every suffix so that each byte is tested in every block position
+  char const* end = input.data() + input.size();
+  for(char const* p = input.data(); p <= end; ++p)
+  {
+    if(expected(p, end) != actual(p, end))
+    {
+      std::cout << "Mismatch in " << name << " at offset " << (p - input.data()) << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+int main()
+{
+  std::vector<qmlon::scan::Kernels const*> kernels;
+  if(qmlon::scan::sse2Kernels())
+    kernels.push_back(qmlon::scan::sse2Kernels());
+  if(qmlon::scan::avx2Kernels())
+    kernels.push_back(qmlon::scan::avx2Kernels());
+
+  std::cout << "Selected kernels: " << qmlon::scan::kernels().name << std::endl;
+
+  char const alphabet[] = " \t\r\n*/\"\\ax";
+  std::srand(1);
+  std::vector<std::string> inputs = {"", " ", "*/", "  \t\n\n  x", std::string(100, ' ') + "*/", std::string(64, 'a') + "\"" };
+  for(int i = 0; i < 200; ++i)
+  {
+    std::string input;
+    int length = std::rand() % 130;
+    for(int j = 0; j < length; ++j)
+    {
+      // Favor long runs of a single class of characters
+      input += alphabet[std::rand() % 4 == 0 ? std::rand() % 10 : (j % 7 ? 0 : 4)];
+    }
+    inputs.push_back(input);
+  }
+
+  qmlon::scan::Kernels const* scalar = qmlon::scan::scalarKernels();
+  for(qmlon::scan::Kernels const* k : kernels)
+  {
+    std::cout << "Testing " << k->name << " kernels" << std::endl;
+    for(std::string const& input : inputs)
+    {
+      if(!compare("skipWhitespace", input, scalar->skipWhitespace, k->skipWhitespace)
+        || !compare("findLineBreak", input, scalar->findLineBreak, k->findLineBreak)
+        || !compare("findBlockCommentEnd", input, scalar->findBlockCommentEnd, k->findBlockCommentEnd)
+        || !compare("findQuoteOrBackslash", input, scalar->findQuoteOrBackslash, k->findQuoteOrBackslash))
+      {
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  std::cout << "All kernels agree" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,184 @@
+#include "qmlon.h"
+#include "qmlonsnapshot.h"
+#include "check.h"
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+std::string generateDocument(int sprites)
+{
+  std::ostringstream ss;
+  ss << "Sheet {\n  image: \"sheet.png\"\n  frames: [Frame { x: 0 }, Frame { x: 32 }]\n";
+  for(int i = 0; i < sprites; ++i)
+  {
+    ss << "  Sprite { id: \"sprite" << i << "\", Animation { id: \"walk\", fps: 10 }, Animation { id: \"jump\", fps: 20 } }\n";
+  }
+  ss << "}\n";
+  return ss.str();
+}
+
+// Sum of the frame rates of all animations
+long sumFps(qmlon::Value const& root)
+{
+  long sum = 0;
+  for(auto const& sprite : root.asObject().children)
+  {
+    for(auto const& animation : sprite->children)
+    {
+      sum += animation->getProperty("fps")->asInteger();
+    }
+  }
+  return sum;
+}
+
+int main(int argc, char** argv)
+{
+  bool ok = true;
+
+  std::string text = generateDocument(1000);
+  qmlon::Snapshot::Reference first = qmlon::Snapshot::create(qmlon::readDocument(qmlon::Source::fromString(text)));
+  qmlon::Object const& sheet = first->getRoot().asObject();
+  qmlon::Object const& walk = *sheet.children[500]->children[0];
+  bool threw = false;
+
+  qmlon::Snapshot::Reference second = first->setProperty(walk, qmlon::Atom("fps"), qmlon::Value::createInteger(12));
+  qmlon::Object const& sheet2 = second->getRoot().asObject();
+  ok &= check("updated", sheet2.children[500]->children[0]->getProperty("fps")->asInteger() == 12);
+  ok &= check("previous unchanged", walk.getProperty("fps")->asInteger() == 10 && first->getRoot().str() == qmlon::readValue(text)->str());
+  ok &= check("path copied", &sheet2 != &sheet && sheet2.children[500] != sheet.children[500]
+    && sheet2.children[500]->children[0] != sheet.children[500]->children[0]);
+  ok &= check("rest shared", sheet2.children[499] == sheet.children[499]
+    && sheet2.children[500]->children[1] == sheet.children[500]->children[1]
+    && sheet2.getProperty("frames")->tryAsList() == sheet.getProperty("frames")->tryAsList());
+
+  std::vector<qmlon::Object const*> path = {&sheet2, sheet2.children[10], sheet2.children[10]->children[1]};
+  qmlon::Snapshot::Reference byPath = second->update(path, [](qmlon::Object& copy, qmlon::Document&) {
+    copy.setProperty(qmlon::Atom("fps"), qmlon::Value::createInteger(25));
+  });
+  ok &= check("update by path", byPath->getRoot().asObject().children[10]->children[1]->getProperty("fps")->asInteger() == 25
+    && byPath->getRoot().asObject().children[500]->children[0]->getProperty("fps")->asInteger() == 12);
+  path[1] = sheet2.children[11];
+  threw = false;
+  try
+  {
+    second->update(path, [](qmlon::Object&, qmlon::Document&) {});
+  }
+  catch(std::invalid_argument const&)
+  {
+    threw = true;
+  }
+  ok &= check("invalid path", threw);
+
+  std::string name = "a name long enough not to be stored inline";
+  qmlon::Snapshot::Reference third = second->setProperty(*sheet2.getProperty("frames")->asList()[1].tryAsObject(),
+                                                         qmlon::Atom("name"), qmlon::Value::createString(name));
+  name.assign(name.size(), 'x');
+  qmlon::Object const& sheet3 = third->getRoot().asObject();
+  ok &= check("object in a list", sheet3.getProperty("frames")->asList()[1].asObject().getProperty("name")->asString()
+    == "a name long enough not to be stored inline" && !sheet2.getProperty("frames")->asList()[1].asObject().hasProperty("name"));
+
+  qmlon::Snapshot::Reference fourth = third->removeChild(sheet3, *sheet3.children[0]);
+  ok &= check("removed child", fourth->getRoot().asObject().children.size() == 999 && sheet3.children.size() == 1000
+    && fourth->getRoot().asObject().children[0] == sheet3.children[1]);
+
+  threw = false;
+  try
+  {
+    fourth->setProperty(*sheet3.children[0], qmlon::Atom("fps"), qmlon::Value::createInteger(1));
+  }
+  catch(std::invalid_argument const&)
+  {
+    threw = true;
+  }
+  ok &= check("object of another snapshot", threw);
+
+  qmlon::Snapshot::Reference compact = fourth->compact();
+  ok &= check("compact", compact->getRoot().str() == fourth->getRoot().str()
+    && compact->getRoot().asObject().children[0] != fourth->getRoot().asObject().children[0]);
+
+  // Deduplicated documents share equal objects, so one object can be in
+  // a list several times. Every occurrence is updated.
+  qmlon::Snapshot::Reference shared1 = qmlon::Snapshot::create(qmlon::readDocumentDeduplicated(
+    qmlon::Source::fromString("Root { sizes: [Size { w: 1 }, Size { w: 1 }, Size { w: 2 }], size: Size { w: 1 } }")));
+  qmlon::Value::List const& sizes1 = shared1->getRoot().asObject().getProperty("sizes")->asList();
+  qmlon::Snapshot::Reference shared2 = shared1->setProperty(sizes1[0].asObject(), qmlon::Atom("w"), qmlon::Value::createInteger(3));
+  qmlon::Object const& root2 = shared2->getRoot().asObject();
+  qmlon::Value::List const& sizes2 = root2.getProperty("sizes")->asList();
+  ok &= check("shared object updated everywhere", &sizes1[0].asObject() == &sizes1[1].asObject()
+    && sizes2[0].asObject().getProperty("w")->asInteger() == 3 && sizes2[1].asObject().getProperty("w")->asInteger() == 3
+    && root2.getProperty("size")->asObject().getProperty("w")->asInteger() == 3
+    && sizes2[2].asObject().getProperty("w")->asInteger() == 2 && &sizes2[2].asObject() == &sizes1[2].asObject());
+
+  qmlon::Value::Reference root = first->getRootReference();
+  first.reset();
+  ok &= check("root reference", root->asObject().children.size() == 1000);
+
+  // Each update keeps the sum of frame rates the same, so readers see it
+  // unchanged as long as they see whole snapshots
+  qmlon::SharedSnapshot shared(qmlon::Snapshot::create(qmlon::readDocumentOnDemand(qmlon::Source::fromString(generateDocument(200)))));
+  long expected = sumFps(shared.get()->getRoot());
+  std::atomic<bool> done(false);
+  std::atomic<int> torn(0);
+  std::vector<std::thread> readers;
+  for(int i = 0; i < 4; ++i)
+  {
+    readers.emplace_back([&]() {
+      while(!done)
+      {
+        qmlon::Snapshot::Reference snapshot = shared.get();
+        torn += sumFps(snapshot->getRoot()) != expected;
+      }
+    });
+  }
+
+  std::vector<std::thread> writers;
+  for(int w = 0; w < 2; ++w)
+  {
+    writers.emplace_back([&, w]() {
+      for(int i = 0; i < 100; ++i)
+      {
+        shared.update([&](qmlon::Snapshot const& snapshot) {
+          qmlon::Object const& sprite = *snapshot.getRoot().asObject().children[(i * 7 + w) % 200];
+          long a = sprite.children[0]->getProperty("fps")->asInteger();
+          long b = sprite.children[1]->getProperty("fps")->asInteger();
+          return snapshot.update(sprite, [&](qmlon::Object& copy, qmlon::Document& document) {
+            qmlon::Object* first = document.createObject(copy.children[0]->type);
+            qmlon::Object* second = document.createObject(copy.children[1]->type);
+            first->setProperty(qmlon::Atom("fps"), qmlon::Value::createInteger(a + 1));
+            second->setProperty(qmlon::Atom("fps"), qmlon::Value::createInteger(b - 1));
+            while(!copy.children.empty())
+            {
+              copy.children.erase(copy.children.begin());
+            }
+            copy.children.push_back(first);
+            copy.children.push_back(second);
+          });
+        });
+      }
+    });
+  }
+  for(std::thread& writer : writers)
+  {
+    writer.join();
+  }
+  done = true;
+  for(std::thread& reader : readers)
+  {
+    reader.join();
+  }
+
+  qmlon::Snapshot::Reference last = shared.get();
+  long moved = 0;
+  for(auto const& sprite : last->getRoot().asObject().children)
+  {
+    moved += sprite->children[0]->getProperty("fps")->asInteger() - 10;
+  }
+  ok &= check("concurrent readers", torn == 0 && sumFps(last->getRoot()) == expected);
+  ok &= check("no lost updates", moved == 200);
+
+  return report(ok, "Snapshots are shared and updated as expected");
+}
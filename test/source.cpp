@@ -0,0 +1,87 @@
+#include "qmlon.h"
+#include "check.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#endif
+
+std::string const TEXT = "Foo { a: \"a string that is not inline\", b: [1, 2, 3] }";
+
+void writeFile(std::string const& filename, std::string const& content)
+{
+  std::ofstream out(filename, std::ios::out | std::ios::binary);
+  out << content;
+}
+
+bool throwsOnOpen(std::string const& filename)
+{
+  try
+  {
+    qmlon::Source::fromFile(filename);
+  }
+  catch(std::runtime_error const& e)
+  {
+    return std::string(e.what()).find(filename) != std::string::npos;
+  }
+  return false;
+}
+
+int main(int argc, char** argv)
+{
+  bool ok = true;
+
+  // Regular files are mapped and strings refer to the mapping
+  writeFile("source_test.qmlon", TEXT);
+  qmlon::Source::Reference file = qmlon::Source::fromFile("source_test.qmlon");
+  ok &= check("regular file", file->str() == qmlon::StringRef(TEXT));
+#if defined(__unix__) || defined(__APPLE__)
+  ok &= check("mapped", file->isMapped());
+#endif
+  qmlon::Value::Reference root = qmlon::readFile("source_test.qmlon");
+  ok &= check("read mapped", root->asObject().getProperty("a")->asString() == "a string that is not inline");
+
+  // Empty files can not be mapped and are read instead
+  writeFile("source_empty.qmlon", "");
+  qmlon::Source::Reference empty = qmlon::Source::fromFile("source_empty.qmlon");
+  ok &= check("empty file", empty->length() == 0 && !empty->isMapped() && empty->str().empty());
+
+  ok &= check("missing file", throwsOnOpen("source_missing.qmlon"));
+
+  // Streams and pipes are read into memory
+  std::istringstream stream(TEXT);
+  qmlon::Source::Reference streamed = qmlon::Source::fromStream(stream);
+  ok &= check("stream", streamed->str() == qmlon::StringRef(TEXT) && !streamed->isMapped());
+
+#if defined(__unix__) || defined(__APPLE__)
+  std::remove("source_pipe");
+  if(mkfifo("source_pipe", 0600) == 0)
+  {
+    std::string large;
+    for(int i = 0; i < 10000; ++i)
+    {
+      large += TEXT + "\n";
+    }
+
+    // Opening either end of the pipe waits for the other one
+    std::thread writer([&]() { writeFile("source_pipe", large); });
+    qmlon::Source::Reference piped = qmlon::Source::fromFile("source_pipe");
+    writer.join();
+    ok &= check("pipe", piped->str() == qmlon::StringRef(large) && !piped->isMapped());
+    std::remove("source_pipe");
+  }
+  else
+  {
+    ok &= check("mkfifo", false);
+  }
+#endif
+
+  std::remove("source_test.qmlon");
+  std::remove("source_empty.qmlon");
+
+  return report(ok, "Sources are mapped or read as expected");
+}
@@ -0,0 +1,47 @@
+#include "qmlon.h"
+#include "check.h"
+#include <iostream>
+#include <cstdlib>
+
+int main(int argc, char** argv)
+{
+  qmlon::Value::Reference root = qmlon::readValue(
+    "Foo { b: true, i: -12, f: 2.5, short: \"fourteen chars\", long: \"fifteen chars!!\", l: [1, \"x\"], o: Bar {} }");
+  qmlon::Object& foo = root->asObject();
+
+  bool ok = true;
+  ok &= check("boolean", foo.getProperty("b")->asBoolean() == true);
+  ok &= check("integer", foo.getProperty("i")->asInteger() == -12);
+  ok &= check("integer as float", foo.getProperty("i")->isFloat() && foo.getProperty("i")->asFloat() == -12.0f);
+  ok &= check("float", foo.getProperty("f")->asFloat() == 2.5f && !foo.getProperty("f")->isInteger());
+  ok &= check("inline string", foo.getProperty("short")->asString() == "fourteen chars");
+  ok &= check("long string", foo.getProperty("long")->asString() == "fifteen chars!!");
+  ok &= check("list", foo.getProperty("l")->asList().size() == 2 && foo.getProperty("l")->asList()[1].asString() == "x");
+  ok &= check("object", foo.getProperty("o")->asObject().type == "Bar");
+
+  int i = 0;
+  float f = 0;
+  qmlon::StringRef s;
+  ok &= check("tryAsInteger", foo.getProperty("i")->tryAsInteger(i) && i == -12);
+  ok &= check("tryAsFloat", foo.getProperty("i")->tryAsFloat(f) && f == -12.0f);
+  ok &= check("tryAsInteger mismatch", !foo.getProperty("f")->tryAsInteger(i) && i == -12);
+  ok &= check("tryAsStringRef", foo.getProperty("long")->tryAsStringRef(s) && s == "fifteen chars!!");
+  ok &= check("tryAsObject", foo.getProperty("o")->tryAsObject() && !foo.getProperty("l")->tryAsObject());
+  ok &= check("tryAsList", foo.getProperty("l")->tryAsList() && !foo.getProperty("o")->tryAsList());
+
+  try
+  {
+    foo.getProperty("b")->asString();
+    ok &= check("type mismatch throws", false);
+  }
+  catch(std::runtime_error const& e)
+  {
+    ok &= check("type mismatch message", std::string(e.what()) == "Invalid use of QMLON value. Value type is not string!");
+  }
+
+  // Copies of inline strings carry their data along
+  qmlon::Value copy = *foo.getProperty("short");
+  ok &= check("copied inline string", copy.asStringRef() == "fourteen chars" && copy.asStringRef().data() != foo.getProperty("short")->asStringRef().data());
+
+  return report(ok, "Values behave correctly");
+}
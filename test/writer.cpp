@@ -0,0 +1,139 @@
+#include "qmlon.h"
+#include "qmlonwriter.h"
+#include "check.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+// Writes a value, reads it back and writes it again
+bool roundTrip(qmlon::Value const& value, qmlon::Writer::Mode mode)
+{
+  std::string text = qmlon::writeText(value, mode);
+  return qmlon::writeText(*qmlon::readValue(text), mode) == text && qmlon::readValue(text)->str() == value.str();
+}
+
+// Records the sizes of the blocks written to it
+class ChunkCounter : public std::streambuf
+{
+public:
+  std::vector<std::size_t> chunks;
+  std::string text;
+
+protected:
+  std::streamsize xsputn(char const* s, std::streamsize n)
+  {
+    chunks.push_back(n);
+    text.append(s, n);
+    return n;
+  }
+
+  int overflow(int c)
+  {
+    if(c != EOF)
+    {
+      chunks.push_back(1);
+      text += static_cast<char>(c);
+    }
+    return c;
+  }
+};
+
+// Whether the text is written in several blocks of bounded size
+bool streamed(qmlon::Value const& value, qmlon::Writer::Mode mode)
+{
+  ChunkCounter counter;
+  std::ostream out(&counter);
+  qmlon::writeText(value, out, mode);
+
+  std::size_t largest = 0;
+  for(std::size_t chunk : counter.chunks)
+  {
+    largest = std::max(largest, chunk);
+  }
+  return counter.text == qmlon::writeText(value, mode) && counter.chunks.size() > 10 && largest < 65 * 1024;
+}
+
+bool exactFloat(double d)
+{
+  std::string text = qmlon::writeText(qmlon::Value::createFloat(d));
+  qmlon::Value::Reference back = qmlon::readValue(text);
+  return back->isFloat() && back->asDouble() == d && std::signbit(back->asDouble()) == std::signbit(d);
+}
+
+int main(int argc, char** argv)
+{
+  bool ok = true;
+
+  qmlon::Value::Reference sheet = qmlon::readFile("spritesheet.qmlon");
+  ok &= check("spritesheet pretty", roundTrip(*sheet, qmlon::Writer::PRETTY));
+  ok &= check("spritesheet compact", roundTrip(*sheet, qmlon::Writer::COMPACT));
+
+  qmlon::Value::Reference values = qmlon::readValue(
+    "Foo { b: true, i: -9223372036854775808, f: -0.0, s: \"\", l: [[], [1, \"x\", [2.5]], Bar {}], {}, Baz { Qux {} } }");
+  ok &= check("values pretty", roundTrip(*values, qmlon::Writer::PRETTY));
+  ok &= check("values compact", roundTrip(*values, qmlon::Writer::COMPACT));
+
+  ok &= check("compact format", qmlon::writeText(*qmlon::readValue("Foo { a: 1, l: [1, 2], Bar {}, {} }"), qmlon::Writer::COMPACT)
+    == "Foo{a:1,l:[1,2],Bar{},{}}");
+  ok &= check("pretty format", qmlon::writeText(*qmlon::readValue("Foo { a: 1, l: [1, 2], o: [Bar {}], Baz { b: false } }"))
+    == "Foo {\n  a: 1\n  l: [1, 2]\n  o: [\n    Bar {}\n  ]\n  Baz {\n    b: false\n  }\n}");
+
+  // Large documents are passed to the stream in bounded blocks
+  std::ostringstream large;
+  large << "Sheet {";
+  for(int i = 0; i < 20000; ++i)
+  {
+    large << " Sprite { id: \"sprite" << i << "\", size: Size { width: 32, height: 32 }, tags: [\"a\", \"b\", " << i << "] }";
+  }
+  large << " }";
+  qmlon::Value::Reference document = qmlon::readValue(large.str());
+  ok &= check("streamed compact", streamed(*document, qmlon::Writer::COMPACT));
+  ok &= check("streamed pretty", streamed(*document, qmlon::Writer::PRETTY));
+
+  ok &= check("escaping", qmlon::writeText(qmlon::Value::createString("a\"b\\c\nd\te\x01"))
+    == "\"a\\\"b\\\\c\\nd\\te\\u0001\"");
+
+  ok &= check("short floats", qmlon::writeText(qmlon::Value::createFloat(0.1)) == "0.1"
+    && qmlon::writeText(qmlon::Value::createFloat(3)) == "3.0"
+    && qmlon::writeText(qmlon::Value::createFloat(-0.005)) == "-0.005"
+    && qmlon::writeText(qmlon::Value::createFloat(1e20)) == "100000000000000000000.0");
+
+  double const special[] = {
+    0.1 + 0.2, 1.0 / 3, 5e-324, 2.2250738585072014e-308, 1.7976931348623157e308,
+    9007199254740993.0, 123456789012345680.0, 0.30000000000000004, -0.0
+  };
+  for(double d : special)
+  {
+    ok &= check("exact float " + std::to_string(d), exactFloat(d));
+  }
+
+  std::mt19937_64 random(16);
+  std::uniform_real_distribution<double> uniform(-1000, 1000);
+  bool allExact = true;
+  for(int i = 0; i < 100000; ++i)
+  {
+    std::uint64_t bits = random();
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    allExact &= exactFloat(std::isfinite(d) ? d : uniform(random));
+    allExact &= exactFloat(uniform(random));
+  }
+  ok &= check("random floats", allExact);
+
+  try
+  {
+    qmlon::writeText(qmlon::Value::createFloat(INFINITY));
+    ok &= check("non-finite throws", false);
+  }
+  catch(std::domain_error const&)
+  {
+  }
+
+  return report(ok, "Written text reads back the same");
+}
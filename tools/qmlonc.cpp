@@ -0,0 +1,50 @@
+#include "qmlon.h"
+#include "qmlonbinary.h"
+#include "qmlonwriter.h"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// Compiles QMLON documents to the binary format, or with -t converts them
+// back to text. The input may be either.
+int main(int argc, char** argv)
+{
+  bool text = argc == 4 && std::strcmp(argv[1], "-t") == 0;
+  if(argc != 3 && !text)
+  {
+    std::cerr << "Usage: " << argv[0] << " [-t] <input> <output>" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  char const* input = argv[argc - 2];
+  char const* output = argv[argc - 1];
+
+  try
+  {
+    qmlon::Value::Reference value = qmlon::readFile(input);
+    std::ofstream out(output, std::ios::out | std::ios::binary);
+    if(text)
+    {
+      qmlon::writeText(*value, out);
+      out << std::endl;
+    }
+    else
+    {
+      qmlon::writeBinary(*value, out);
+    }
+
+    if(!out)
+    {
+      std::cerr << "ERROR: Could not write " << output << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  catch(std::exception const& e)
+  {
+    std::cerr << input << ": " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
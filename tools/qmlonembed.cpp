@@ -0,0 +1,98 @@
+#include "qmlon.h"
+#include "qmlonbinary.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace
+{
+  bool isIdentifier(std::string const& name)
+  {
+    if(name.empty() || (name[0] >= '0' && name[0] <= '9'))
+    {
+      return false;
+    }
+    for(char c : name)
+    {
+      if(!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_'))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Always writes the file, even if its content is the same, so that it is
+  // newer than the input and the build does not run the tool again
+  bool write(std::string const& filename, std::string const& content)
+  {
+    std::ofstream out(filename, std::ios::out | std::ios::binary);
+    out << content;
+    return bool(out);
+  }
+}
+
+// Embeds a QMLON document in a program. The document is compiled to the
+// binary format and written as a static array into a source file, with a
+// header declaring a function that reads it in place. The input may be
+// text or binary.
+int main(int argc, char** argv)
+{
+  if(argc != 5 || !isIdentifier(argv[4]))
+  {
+    std::cerr << "Usage: " << argv[0] << " <input> <header> <source> <function name>" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  char const* input = argv[1];
+  std::string inputName = std::string(input).substr(std::string(input).find_last_of("/\\") + 1);
+  std::string header = argv[2];
+  std::string source = argv[3];
+  std::string name = argv[4];
+
+  std::string compiled;
+  try
+  {
+    compiled = qmlon::writeBinary(*qmlon::readFile(input));
+  }
+  catch(std::exception const& e)
+  {
+    std::cerr << input << ": " << e.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::ostringstream h;
+  h << "// Generated by qmlon-embed from " << inputName << ", do not edit\n"
+    << "#ifndef QMLON_EMBEDDED_" << name << "\n"
+    << "#define QMLON_EMBEDDED_" << name << "\n\n"
+    << "#include \"qmlon.h\"\n\n"
+    << "// Reads the embedded document without parsing or copying it\n"
+    << "qmlon::Value::Reference " << name << "();\n\n"
+    << "#endif\n";
+
+  std::ostringstream s;
+  std::string base = header.substr(header.find_last_of("/\\") + 1);
+  s << "// Generated by qmlon-embed from " << inputName << ", do not edit\n"
+    << "#include \"" << base << "\"\n"
+    << "#include \"qmlonbinary.h\"\n\n"
+    << "namespace\n{\n"
+    << "  unsigned char const DATA[" << compiled.size() << "] = {";
+  for(std::size_t i = 0; i < compiled.size(); ++i)
+  {
+    s << (i % 16 == 0 ? "\n    " : " ") << unsigned(static_cast<unsigned char>(compiled[i])) << ",";
+  }
+  s << "\n  };\n}\n\n"
+    << "qmlon::Value::Reference " << name << "()\n{\n"
+    << "  return qmlon::readEmbedded(reinterpret_cast<char const*>(DATA), sizeof(DATA));\n"
+    << "}\n";
+
+  if(!write(header, h.str()) || !write(source, s.str()))
+  {
+    std::cerr << "ERROR: Could not write " << header << " or " << source << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}